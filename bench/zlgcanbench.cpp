@@ -0,0 +1,443 @@
+#include "zlgcantools.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonObject>
+#include <QTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <vector>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+/*!
+ * Throughput and latency benchmark of ZlgCanBackend. Channel 0 and channel 1 of
+ * one device are expected to share a bus, as they do on ZCAN_VIRTUAL_DEVICE and
+ * on every device of the simulated libzlgcan (ZLGCAN_MOCK). Results go to stdout
+ * or --output as JSON:
+ *
+ * - rx_can, rx_canfd: frames/s received on channel 1 while channel 0 keeps a window of frames in flight.
+ * - tx_can, tx_canfd: frames/s confirmed through framesWritten, and the cost of one writeFrame call.
+ *   A window that does not move for window_timeout ms is written off as frames_dropped.
+ * - latency_can, latency_canfd: writeFrame on channel 0 to framesReceived on channel 1, one frame at a time.
+ *
+ * Heap allocations are operator new calls of the whole process; QByteArray payloads
+ * bypass operator new and are reported separately from the payload pool.
+ */
+namespace zlg::bench
+{
+    std::atomic<quint64> heap_allocations{0};
+
+    struct Options: tools::Options
+    {
+        unsigned int index{0};
+        int duration{2000};
+        int warm_up{200};
+        int window{4096};
+        int window_timeout{500};
+        int latency_frames{10000};
+        int transmit_mode{ZlgCanBackend::ThreadTransmitMode};
+    };
+
+    // wall and cpu time in ns
+    struct Sample
+    {
+        qint64 wall{0};
+        qint64 cpu{0};
+        quint64 heap_allocations{0};
+    };
+
+    // frames in flight between writeFrame and their confirmation by the receiver or framesWritten
+    struct Window
+    {
+        int size{0};
+        int timeout{0};
+        qint64 sent{0};
+        qint64 confirmed{0};
+        qint64 dropped{0};
+        qint64 last_confirmed{0};
+        QElapsedTimer idle{};
+
+        // a lost frame or echo is never confirmed, so a window stuck full for timeout ms is written off
+        bool full()
+        {
+            if(confirmed != last_confirmed || !idle.isValid())
+            {
+                last_confirmed = confirmed;
+                idle.start();
+            }
+            // a confirmation arriving after its frame was written off was not dropped after all
+            dropped = qMax(qint64{0}, qMin(dropped, sent - confirmed));
+            if(sent - confirmed - dropped < size)
+            {
+                return false;
+            }
+            if(idle.elapsed() < timeout)
+            {
+                return true;
+            }
+            dropped = sent - confirmed;
+            idle.start();
+            return false;
+        }
+    };
+
+    qint64 cpu_time()
+    {
+#if defined(Q_OS_WIN)
+        FILETIME creation{};
+        FILETIME exit{};
+        FILETIME kernel{};
+        FILETIME user{};
+        ::GetProcessTimes(::GetCurrentProcess(), &creation, &exit, &kernel, &user);
+        auto to_ns{[](const FILETIME& time) {
+            return static_cast<qint64>((static_cast<quint64>(time.dwHighDateTime) << 32) | time.dwLowDateTime) * 100;
+        }};
+        return to_ns(kernel) + to_ns(user);
+#else
+        rusage usage{};
+        ::getrusage(RUSAGE_SELF, &usage);
+        auto to_ns{[](const timeval& time) {
+            return static_cast<qint64>(time.tv_sec) * 1000000000 + static_cast<qint64>(time.tv_usec) * 1000;
+        }};
+        return to_ns(usage.ru_utime) + to_ns(usage.ru_stime);
+#endif
+    }
+
+    Sample sample(const QElapsedTimer& clock)
+    {
+        return {clock.nsecsElapsed(), cpu_time(), heap_allocations.load(std::memory_order_relaxed)};
+    }
+
+    std::unique_ptr<ZlgCanBackend> open_backend(const Options& options, unsigned int channel, bool fd, QString& error)
+    {
+        return tools::open_backend(options, options.index, channel, fd, {
+            {QCanBusDevice::BitRateKey, 1000000},
+            {QCanBusDevice::DataBitRateKey, fd ? 5000000 : 1000000},
+            {ZlgCanBackend::TransmitModeKey, options.transmit_mode},
+            {ZlgCanBackend::TransmitQueueCapacityKey, options.window * 2},
+        }, error);
+    }
+
+    QCanBusFrame make_frame(bool fd, quint64 sequence = 0)
+    {
+        return tools::sequence_frame(0x123, sequence, fd, true);
+    }
+
+    // runs the event loop for warm_up + duration ms, begin and end are called at both ends of the measured window
+    void measure(const Options& options, const std::function<void()>& begin, const std::function<void()>& end)
+    {
+        QEventLoop loop{};
+        QTimer::singleShot(options.warm_up, &loop, begin);
+        QTimer::singleShot(options.warm_up + options.duration, &loop, [&]() {
+            end();
+            loop.quit();
+        });
+        loop.exec();
+    }
+
+    QJsonObject throughput_result(qint64 frames, const Sample& begin, const Sample& end)
+    {
+        const auto wall{static_cast<double>(end.wall - begin.wall)};
+        const auto cpu{static_cast<double>(end.cpu - begin.cpu)};
+        const auto allocations{static_cast<double>(end.heap_allocations - begin.heap_allocations)};
+        QJsonObject result{};
+        result["frames"] = static_cast<double>(frames);
+        result["frames_per_second"] = wall > 0 ? frames * 1e9 / wall : 0.0;
+        result["cpu_ms_per_1k_frames"] = frames ? cpu / 1e6 * 1000 / frames : 0.0;
+        result["heap_allocations_per_frame"] = frames ? allocations / frames : 0.0;
+        return result;
+    }
+
+    QJsonObject error_result(const QString& error)
+    {
+        QJsonObject result{};
+        result["error"] = error;
+        return result;
+    }
+
+    QJsonObject receive_throughput(const Options& options, bool fd)
+    {
+        QString error{};
+        auto sender{open_backend(options, 0, fd, error)};
+        auto receiver{sender ? open_backend(options, 1, fd, error) : nullptr};
+        if(!receiver)
+        {
+            return error_result(error);
+        }
+
+        Window window{options.window, options.window_timeout};
+        auto& received{window.confirmed};
+        QObject::connect(receiver.get(), &QCanBusDevice::framesReceived, receiver.get(), [&]() {
+            received += receiver->readAllFrames().size();
+        });
+
+        // the window keeps the sender from running ahead of the receiver, so the rate measured is the receive rate
+        const auto frame{make_frame(fd)};
+        QTimer feeder{};
+        QObject::connect(&feeder, &QTimer::timeout, [&]() {
+            while(!window.full() && sender->writeFrame(frame))
+            {
+                ++window.sent;
+            }
+        });
+        feeder.start(0);
+
+        QElapsedTimer clock{};
+        clock.start();
+        Sample begin{};
+        Sample end{};
+        auto received_begin{qint64{0}};
+        auto dropped_begin{qint64{0}};
+        auto pool_begin{quint64{0}};
+        auto overflows_begin{quint64{0}};
+        auto frames{qint64{0}};
+        auto dropped{qint64{0}};
+        auto pool_allocations{quint64{0}};
+        auto overflows{quint64{0}};
+        measure(options, [&]() {
+            receiver->resetReceiveLatencyHistogram();
+            received_begin = received;
+            dropped_begin = window.dropped;
+            pool_begin = receiver->payloadPoolStatistics().allocations;
+            overflows_begin = receiver->performanceCounters().bufferOverflows;
+            begin = sample(clock);
+        }, [&]() {
+            end = sample(clock);
+            frames = received - received_begin;
+            dropped = window.dropped - dropped_begin;
+            pool_allocations = receiver->payloadPoolStatistics().allocations - pool_begin;
+            overflows = receiver->performanceCounters().bufferOverflows - overflows_begin;
+        });
+        feeder.stop();
+
+        if(!window.sent)
+        {
+            return error_result(sender->errorString());
+        }
+        auto result{throughput_result(frames, begin, end)};
+        result["frames_dropped"] = static_cast<double>(dropped);
+        result["payload_allocations_per_frame"] = frames ? static_cast<double>(pool_allocations) / frames : 0.0;
+        result["buffer_overflows"] = static_cast<double>(overflows);
+        return result;
+    }
+
+    QJsonObject transmit_throughput(const Options& options, bool fd)
+    {
+        QString error{};
+        auto sender{open_backend(options, 0, fd, error)};
+        if(!sender)
+        {
+            return error_result(error);
+        }
+
+        Window window{options.window, options.window_timeout};
+        auto& written{window.confirmed};
+        QObject::connect(sender.get(), &QCanBusDevice::framesWritten, sender.get(), [&](qint64 count) {
+            written += count;
+        });
+
+        QElapsedTimer clock{};
+        clock.start();
+        auto write_time{qint64{0}};
+        auto write_calls{qint64{0}};
+        const auto frame{make_frame(fd)};
+        QTimer feeder{};
+        QObject::connect(&feeder, &QTimer::timeout, [&]() {
+            while(!window.full())
+            {
+                const auto start{clock.nsecsElapsed()};
+                const auto result{sender->writeFrame(frame)};
+                write_time += clock.nsecsElapsed() - start;
+                ++write_calls;
+                if(!result)
+                {
+                    break;
+                }
+                ++window.sent;
+            }
+        });
+        feeder.start(0);
+
+        Sample begin{};
+        Sample end{};
+        auto written_begin{qint64{0}};
+        auto dropped_begin{qint64{0}};
+        auto frames{qint64{0}};
+        auto dropped{qint64{0}};
+        measure(options, [&]() {
+            written_begin = written;
+            dropped_begin = window.dropped;
+            write_time = 0;
+            write_calls = 0;
+            begin = sample(clock);
+        }, [&]() {
+            end = sample(clock);
+            frames = written - written_begin;
+            dropped = window.dropped - dropped_begin;
+        });
+        feeder.stop();
+
+        if(!window.sent)
+        {
+            return error_result(sender->errorString());
+        }
+        auto result{throughput_result(frames, begin, end)};
+        result["frames_dropped"] = static_cast<double>(dropped);
+        result["write_frame_ns"] = write_calls ? static_cast<double>(write_time) / write_calls : 0.0;
+        return result;
+    }
+
+    QJsonObject loopback_latency(const Options& options, bool fd)
+    {
+        QString error{};
+        auto sender{open_backend(options, 0, fd, error)};
+        auto receiver{sender ? open_backend(options, 1, fd, error) : nullptr};
+        if(!receiver)
+        {
+            return error_result(error);
+        }
+
+        QElapsedTimer clock{};
+        clock.start();
+        QEventLoop loop{};
+        QTimer timeout{};
+        timeout.setSingleShot(true);
+        timeout.setInterval(1000);
+
+        std::vector<qint64> latencies{};
+        latencies.reserve(options.latency_frames);
+        auto lost{0};
+        auto sequence{quint64{0}};
+        auto sent_at{qint64{0}};
+        auto send_next{[&]() {
+            if(static_cast<int>(latencies.size()) + lost >= options.latency_frames)
+            {
+                loop.quit();
+                return;
+            }
+            const auto frame{make_frame(fd, ++sequence)};
+            sent_at = clock.nsecsElapsed();
+            sender->writeFrame(frame);
+            timeout.start();
+        }};
+
+        // a frame not seen within the timeout is lost, a late copy of it is ignored
+        QObject::connect(&timeout, &QTimer::timeout, [&]() {
+            ++lost;
+            send_next();
+        });
+        QObject::connect(receiver.get(), &QCanBusDevice::framesReceived, receiver.get(), [&]() {
+            const auto now{clock.nsecsElapsed()};
+            auto matched{false};
+            for(const auto& frame: receiver->readAllFrames())
+            {
+                matched = matched || sequence == tools::sequence_of(frame);
+            }
+            if(matched)
+            {
+                latencies.push_back(now - sent_at);
+                timeout.stop();
+                send_next();
+            }
+        });
+
+        QTimer::singleShot(0, &loop, send_next);
+        loop.exec();
+
+        if(latencies.empty())
+        {
+            return error_result(QString{"No frame came back: %1"}.arg(sender->errorString()));
+        }
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile{[&](double p) {
+            const auto index{qMin(latencies.size() - 1, static_cast<std::size_t>(p * latencies.size()))};
+            return latencies[index] / 1e3;
+        }};
+        QJsonObject result{};
+        result["frames"] = static_cast<double>(latencies.size());
+        result["lost"] = lost;
+        result["p50_us"] = percentile(0.5);
+        result["p90_us"] = percentile(0.9);
+        result["p99_us"] = percentile(0.99);
+        result["p999_us"] = percentile(0.999);
+        result["max_us"] = latencies.back() / 1e3;
+        return result;
+    }
+} //namespace zlg::bench
+
+void* operator new(std::size_t size)
+{
+    zlg::bench::heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if(auto* pointer{std::malloc(size ? size : 1)})
+    {
+        return pointer;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app{argc, argv};
+
+    QCommandLineParser parser{};
+    parser.setApplicationDescription("Throughput and latency benchmark of ZlgCanBackend, results as JSON.");
+    parser.addHelpOption();
+    const zlg::tools::CommandLine command_line{"ZCAN_VIRTUAL_DEVICE"};
+    command_line.addTo(parser);
+    const QCommandLineOption index_option{"index", "Device index.", "index", "0"};
+    const QCommandLineOption duration_option{"duration", "Measured time of every throughput run in ms.", "ms", "2000"};
+    const QCommandLineOption frames_option{"latency-frames", "Frames sent one at a time by every latency run.", "count", "10000"};
+    const QCommandLineOption no_fd_option{"no-fd", "Skip the CAN FD runs."};
+    parser.addOptions({index_option, duration_option, frames_option, no_fd_option});
+    parser.process(app);
+
+    zlg::bench::Options options{};
+    command_line.read(parser, options);
+    options.index = parser.value(index_option).toUInt();
+    options.duration = qMax(parser.value(duration_option).toInt(), 1);
+    options.latency_frames = qMax(parser.value(frames_option).toInt(), 1);
+    options.fd = !parser.isSet(no_fd_option);
+
+    QJsonObject results{};
+    results["rx_can"] = zlg::bench::receive_throughput(options, false);
+    results["tx_can"] = zlg::bench::transmit_throughput(options, false);
+    results["latency_can"] = zlg::bench::loopback_latency(options, false);
+    if(options.fd)
+    {
+        results["rx_canfd"] = zlg::bench::receive_throughput(options, true);
+        results["tx_canfd"] = zlg::bench::transmit_throughput(options, true);
+        results["latency_canfd"] = zlg::bench::loopback_latency(options, true);
+    }
+
+    QJsonObject report{};
+    report["device"] = options.device;
+    report["index"] = static_cast<int>(options.index);
+    report["receive_mode"] = parser.value(command_line.receive_mode);
+    report["merge_receive"] = options.merge_receive;
+    report["duration_ms"] = options.duration;
+    report["qt_version"] = QString{qVersion()};
+    report["results"] = results;
+    return zlg::tools::write_report(report, parser.value(command_line.output)) ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+# Turns devices.xml into zlgcandevices_table.h, the constexpr zlg::builtin::devices
+# table compiled into the plugin, so devices.xml is never parsed at runtime, and
+# zlg::builtin::device_names, the same devices sorted by name for lookups.
+#
+#   cmake -DINPUT=src/devices.xml -DOUTPUT=zlgcandevices_table.h -P cmake/zlgcandevices.cmake
+#
+# Only the layout devices.xml uses is understood: one <Device> element per adapter,
+# its configuration keys as elements of <Configurations>, and bitrates as <value>
+# children of <BitRate> and <DataBitRate>.
+
+cmake_minimum_required(VERSION 3.14)
+
+if(NOT INPUT OR NOT OUTPUT)
+    message(FATAL_ERROR "zlgcandevices.cmake needs -DINPUT=<devices.xml> -DOUTPUT=<header>")
+endif()
+
+set(KEYS RawFilter ErrorFilter Loopback ReceiveOwn BitRate CanFd DataBitRate)
+set(METHODS ZCAN_INITCAN ZCAN_SETVALUE IPROPERTY_SETVALUE)
+set(SEQUENCES BEFORE_INIT_CAN BEFORE_START_CAN AFTER_START_CAN)
+
+function(read_attribute element name out)
+    if("${element}" MATCHES "[ \t\r\n]${name}=\"([^\"]*)\"")
+        set(${out} "${CMAKE_MATCH_1}" PARENT_SCOPE)
+    else()
+        set(${out} "" PARENT_SCOPE)
+    endif()
+endfunction()
+
+function(read_flag element name out)
+    read_attribute("${element}" ${name} value)
+    string(TOUPPER "${value}" value)
+    if(value STREQUAL "TRUE")
+        set(${out} "true" PARENT_SCOPE)
+    else()
+        set(${out} "false" PARENT_SCOPE)
+    endif()
+endfunction()
+
+function(read_number element name out)
+    read_attribute("${element}" ${name} value)
+    if(NOT value MATCHES "^[0-9]+$")
+        set(value 0)
+    endif()
+    set(${out} "${value}" PARENT_SCOPE)
+endfunction()
+
+# appends "<id>_<field>[]{...}" for the <value>s of a bitrate element to out_arrays, returns the span initializer
+function(read_bitrates device key id field out out_arrays)
+    set(span "{}")
+    if("${device}" MATCHES "<${key}[^>/]*>(.*)</${key}>")
+        string(REGEX MATCHALL "<value>[ \t]*[0-9]+[ \t]*</value>" values "${CMAKE_MATCH_1}")
+        string(REGEX REPLACE "[^0-9;]" "" values "${values}")
+        list(REMOVE_ITEM values 0)
+        if(values)
+            string(TOLOWER "${id}_${field}" span)
+            list(JOIN values ", " values)
+            set(${out_arrays} "${${out_arrays}}    constexpr unsigned int ${span}[]{${values}};\n" PARENT_SCOPE)
+        endif()
+    endif()
+    set(${out} "${span}" PARENT_SCOPE)
+endfunction()
+
+file(READ "${INPUT}" xml)
+string(REGEX REPLACE "<!--([^-]|-[^-])*-->" "" xml "${xml}")
+string(REPLACE ";" "" xml "${xml}")
+string(REPLACE "</Device>" ";" devices "${xml}")
+
+set(arrays "")
+set(entries "")
+set(types "")
+set(names "")
+foreach(device IN LISTS devices)
+    if(NOT device MATCHES "<Device([ \t\r\n][^>]*)>")
+        continue()
+    endif()
+    set(head "${CMAKE_MATCH_1}")
+
+    read_attribute("${head}" name name)
+    string(TOUPPER "${name}" name)
+    read_number("${head}" type type)
+    if(NOT name OR type EQUAL 0)
+        message(FATAL_ERROR "${INPUT}: <Device${head}> needs a name and a non-zero type")
+    endif()
+    if(type IN_LIST types)
+        message(FATAL_ERROR "${INPUT}: device type ${type} is listed twice")
+    endif()
+    list(APPEND types ${type})
+    if(name IN_LIST names)
+        message(FATAL_ERROR "${INPUT}: device name ${name} is listed twice")
+    endif()
+    list(APPEND names "${name}")
+    string(MAKE_C_IDENTIFIER "${name}" id)
+    set(type_of_${id} ${type})
+
+    read_flag("${head}" fd fd)
+    read_number("${head}" channels channels)
+    read_flag("${head}" merge_receive merge_receive)
+    read_flag("${head}" transmit_data transmit_data)
+    read_flag("${head}" delay_send delay_send)
+    read_number("${head}" auto_send auto_send)
+    read_number("${head}" filters filters)
+
+    set(configurations "")
+    foreach(key IN LISTS KEYS)
+        if("${device}" MATCHES "<${key}([ \t\r\n][^>]*)?>")
+            set(element "${CMAKE_MATCH_1}")
+            read_flag("${element}" configurable configurable)
+            read_attribute("${element}" method method)
+            read_attribute("${element}" sequence sequence)
+            string(TOUPPER "${method}" method)
+            string(TOUPPER "${sequence}" sequence)
+            if(NOT method IN_LIST METHODS)
+                set(method ZCAN_SETVALUE)
+            endif()
+            if(NOT sequence IN_LIST SEQUENCES)
+                set(sequence BEFORE_INIT_CAN)
+            endif()
+            string(APPEND configurations "                {QCanBusDevice::${key}Key, ${configurable}, ConfigureFunction::${method}, ConfigureOrder::${sequence}},\n")
+        else()
+            string(APPEND configurations "                {QCanBusDevice::${key}Key},\n")
+        endif()
+    endforeach()
+
+    read_bitrates("${device}" BitRate ${id} bitrate bitrate arrays)
+    read_bitrates("${device}" DataBitRate ${id} data_field_bitrate data_field_bitrate arrays)
+
+    string(APPEND entries
+        "        Device{\n"
+        "            .name = \"${name}\",\n"
+        "            .type = ${type},\n"
+        "            .fd = ${fd},\n"
+        "            .channels = ${channels},\n"
+        "            .merge_receive = ${merge_receive},\n"
+        "            .transmit_data = ${transmit_data},\n"
+        "            .delay_send = ${delay_send},\n"
+        "            .auto_send = ${auto_send},\n"
+        "            .filters = ${filters},\n"
+        "            .configurations{{\n"
+        "${configurations}"
+        "            }},\n"
+        "            .bitrate = ${bitrate},\n"
+        "            .data_field_bitrate = ${data_field_bitrate},\n"
+        "        },\n")
+endforeach()
+
+if(NOT entries)
+    message(FATAL_ERROR "${INPUT}: no <Device> elements")
+endif()
+
+# byte order, which is what get_device_type() searches the names by
+list(SORT names COMPARE STRING)
+set(name_entries "")
+foreach(name IN LISTS names)
+    string(MAKE_C_IDENTIFIER "${name}" id)
+    string(APPEND name_entries "        {\"${name}\", ${type_of_${id}}},\n")
+endforeach()
+
+set(header
+"// Generated from devices.xml by cmake/zlgcandevices.cmake, do not edit.
+
+#ifndef ZLGCANDEVICES_TABLE_H
+#define ZLGCANDEVICES_TABLE_H
+
+#include \"zlgcandevices_p.h\"
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg::builtin
+{
+${arrays}
+    constexpr Device devices[]{
+${entries}    };
+
+    constexpr DeviceName device_names[]{
+${name_entries}    };
+} //namespace zlg::builtin
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANDEVICES_TABLE_H
+")
+
+# rewriting an unchanged header would rebuild everything including it
+if(EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" current)
+endif()
+if(NOT current STREQUAL header)
+    file(WRITE "${OUTPUT}" "${header}")
+endif()
@@ -0,0 +1,723 @@
+#include "zlgcanmock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*!
+ * Simulated zlgcan library. Every opened device is one virtual bus: a frame
+ * transmitted on a channel is received by all other started channels of the same
+ * device, and echoed back to the sender when it asked for an echo. Behaviour is
+ * configured through the environment:
+ *
+ * - ZLGCAN_MOCK_CHANNELS: channels per device, 4 by default.
+ * - ZLGCAN_MOCK_RATE: frames per second generated on every started channel, 0 by default.
+ * - ZLGCAN_MOCK_ERROR_RATE: probability in [0, 1] that a transmitted frame is refused with
+ *   a buffer overflow, and that a generated frame is replaced by a bus error, 0 by default.
+ * - ZLGCAN_MOCK_LOOPBACK: 0 stops delivering transmitted frames to the other channels.
+ * - ZLGCAN_MOCK_QUEUE_CAPACITY: records kept per receive queue before overflowing, 65536 by default.
+ *
+ * Bus faults are injected through ZCAN_MOCK_InjectFault, see zlgcanmock.h. Only
+ * the extern "C" entry points are exported, the simulation itself is internal.
+ */
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Settings
+    {
+        unsigned int channels{4};
+        double rate{0.0};
+        double error_rate{0.0};
+        bool loopback{true};
+        std::size_t queue_capacity{65536};
+
+        static const Settings& get()
+        {
+            static const auto settings{[]() {
+                Settings settings{};
+                auto read{[](const char* name, auto fallback) {
+                    const auto* value{std::getenv(name)};
+                    return value && *value ? static_cast<decltype(fallback)>(std::strtod(value, nullptr)) : fallback;
+                }};
+                settings.channels = std::clamp(read("ZLGCAN_MOCK_CHANNELS", settings.channels), 1U, 255U);
+                settings.rate = std::max(read("ZLGCAN_MOCK_RATE", settings.rate), 0.0);
+                settings.error_rate = std::clamp(read("ZLGCAN_MOCK_ERROR_RATE", settings.error_rate), 0.0, 1.0);
+                settings.loopback = read("ZLGCAN_MOCK_LOOPBACK", 1) != 0;
+                settings.queue_capacity = std::max<std::size_t>(read("ZLGCAN_MOCK_QUEUE_CAPACITY", settings.queue_capacity), 1);
+                return settings;
+            }()};
+            return settings;
+        }
+    };
+
+    struct Device;
+
+    struct Channel
+    {
+        Device* device{};
+        unsigned int index{0};
+        bool fd{false};
+        bool started{false};
+        unsigned int error_code{0};
+        unsigned int fault_code{0};
+        std::deque<ZCANDataObj> can{};
+        std::deque<ZCANDataObj> canfd{};
+        Clock::time_point next_frame{};
+        std::uint64_t sequence{0};
+    };
+
+    struct Device
+    {
+        unsigned int type{0};
+        unsigned int index{0};
+        Clock::time_point opened{Clock::now()};
+        bool merge{false};
+        bool closing{false};
+        bool unplugged{false};
+        int receivers{0};
+        std::deque<ZCANDataObj> merged{};
+        std::vector<Channel> channels{};
+        std::mutex mutex{};
+        std::condition_variable available{};
+        std::condition_variable wake{};
+        std::condition_variable left{};
+        std::thread generator{};
+        std::mt19937 random{std::random_device{}()};
+
+        std::uint64_t now() const
+        {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - opened).count());
+        }
+
+        bool fail()
+        {
+            const auto error_rate{Settings::get().error_rate};
+            return error_rate > 0.0 && std::uniform_real_distribution<double>{0.0, 1.0}(random) < error_rate;
+        }
+    };
+
+    std::mutex devices_mutex{};
+    std::map<std::pair<unsigned int, unsigned int>, std::unique_ptr<Device>> devices{};
+
+    Device* device_of(DEVICE_HANDLE handle)
+    {
+        return static_cast<Device*>(handle);
+    }
+
+    Channel* channel_of(CHANNEL_HANDLE handle)
+    {
+        return static_cast<Channel*>(handle);
+    }
+
+    // called with the device mutex held; error records only exist in merged reception
+    void deliver(Device& device, Channel& channel, ZCANDataObj record)
+    {
+        if(!channel.started || device.unplugged || (ZCAN_ERROR_CAN_BUSOFF & channel.fault_code))
+        {
+            return;
+        }
+        if(!device.merge && ZCAN_DT_ZCAN_CAN_CANFD_DATA != record.dataType)
+        {
+            return;
+        }
+        record.chnl = static_cast<BYTE>(channel.index);
+        auto& queue{device.merge ? device.merged : 1 == record.data.zcanCANFDData.flag.unionVal.frameType ? channel.canfd : channel.can};
+        if(queue.size() >= Settings::get().queue_capacity)
+        {
+            channel.error_code |= ZCAN_ERROR_CAN_BUFFER_OVERFLOW;
+            return;
+        }
+        queue.push_back(record);
+    }
+
+    // called with the device mutex held
+    bool transmit(Device& device, Channel& channel, ZCANDataObj record)
+    {
+        if(!channel.started || device.unplugged)
+        {
+            return false;
+        }
+        if(ZCAN_ERROR_CAN_BUSOFF & channel.fault_code)
+        {
+            channel.error_code |= ZCAN_ERROR_CAN_BUSOFF;
+            return false;
+        }
+        if(device.fail())
+        {
+            channel.error_code |= ZCAN_ERROR_CAN_BUFFER_OVERFLOW;
+            return false;
+        }
+
+        auto& can_data{record.data.zcanCANFDData};
+        const auto echo{can_data.flag.unionVal.txEchoRequest};
+        can_data.timeStamp = device.now();
+        can_data.flag.unionVal.txDelay = 0;
+        can_data.flag.unionVal.txEchoRequest = 0;
+        if(Settings::get().loopback)
+        {
+            for(auto& other: device.channels)
+            {
+                if(&other != &channel)
+                {
+                    deliver(device, other, record);
+                }
+            }
+        }
+        if(echo && device.merge)
+        {
+            can_data.flag.unionVal.txEchoed = 1;
+            deliver(device, channel, record);
+        }
+        return true;
+    }
+
+    ZCANDataObj to_record(const ZCAN_Transmit_Data& data)
+    {
+        ZCANDataObj record{};
+        record.dataType = ZCAN_DT_ZCAN_CAN_CANFD_DATA;
+        auto& can_data{record.data.zcanCANFDData};
+        can_data.flag.unionVal.txEchoRequest = IS_TX_ECHO(data.frame.__pad) ? 1 : 0;
+        can_data.frame.can_id = data.frame.can_id;
+        can_data.frame.len = std::min<BYTE>(data.frame.can_dlc, CAN_MAX_DLEN);
+        std::memcpy(can_data.frame.data, data.frame.data, can_data.frame.len);
+        return record;
+    }
+
+    ZCANDataObj to_record(const ZCAN_TransmitFD_Data& data)
+    {
+        ZCANDataObj record{};
+        record.dataType = ZCAN_DT_ZCAN_CAN_CANFD_DATA;
+        auto& can_data{record.data.zcanCANFDData};
+        can_data.flag.unionVal.frameType = 1;
+        can_data.flag.unionVal.txEchoRequest = IS_TX_ECHO(data.frame.flags) ? 1 : 0;
+        can_data.frame = data.frame;
+        can_data.frame.flags &= CANFD_BRS | CANFD_ESI;
+        can_data.frame.len = std::min<BYTE>(data.frame.len, CANFD_MAX_DLEN);
+        return record;
+    }
+
+    void from_record(const ZCANDataObj& record, ZCAN_Receive_Data& data)
+    {
+        const auto& can_data{record.data.zcanCANFDData};
+        std::memset(&data, 0, sizeof(data));
+        data.frame.can_id = can_data.frame.can_id;
+        data.frame.can_dlc = std::min<BYTE>(can_data.frame.len, CAN_MAX_DLEN);
+        std::memcpy(data.frame.data, can_data.frame.data, data.frame.can_dlc);
+        data.timestamp = can_data.timeStamp;
+    }
+
+    void from_record(const ZCANDataObj& record, ZCAN_ReceiveFD_Data& data)
+    {
+        std::memset(&data, 0, sizeof(data));
+        data.frame = record.data.zcanCANFDData.frame;
+        data.timestamp = record.data.zcanCANFDData.timeStamp;
+    }
+
+    template<typename T>
+    UINT transmit(CHANNEL_HANDLE channel_handle, const T* data, UINT len)
+    {
+        auto* channel{channel_of(channel_handle)};
+        if(!channel || !data)
+        {
+            return 0;
+        }
+        auto& device{*channel->device};
+        auto count{UINT{0}};
+        {
+            const std::lock_guard<std::mutex> locker{device.mutex};
+            while(count < len && transmit(device, *channel, to_record(data[count])))
+            {
+                ++count;
+            }
+        }
+        device.available.notify_all();
+        return count;
+    }
+
+    // waits up to wait_time ms, forever when negative, for the queue to hold records
+    template<typename T>
+    UINT receive(Device& device, std::deque<ZCANDataObj>& queue, T* data, UINT len, int wait_time)
+    {
+        if(!data || !len)
+        {
+            return 0;
+        }
+        std::unique_lock<std::mutex> locker{device.mutex};
+        // an unplugged device times out like an idle one
+        auto ready{[&]() {
+            return (!queue.empty() && !device.unplugged) || device.closing;
+        }};
+        if(wait_time < 0)
+        {
+            ++device.receivers;
+            device.available.wait(locker, ready);
+            --device.receivers;
+        }
+        else if(wait_time > 0)
+        {
+            ++device.receivers;
+            device.available.wait_for(locker, std::chrono::milliseconds{wait_time}, ready);
+            --device.receivers;
+        }
+        if(device.closing)
+        {
+            // ZCAN_CloseDevice frees the device once the last waiting receiver is gone
+            device.left.notify_all();
+            return 0;
+        }
+
+        const auto count{device.unplugged ? UINT{0} : static_cast<UINT>(std::min<std::size_t>(len, queue.size()))};
+        for(auto i{UINT{0}}; i < count; ++i)
+        {
+            if constexpr(std::is_same_v<T, ZCANDataObj>)
+            {
+                data[i] = queue.front();
+            }
+            else
+            {
+                from_record(queue.front(), data[i]);
+            }
+            queue.pop_front();
+        }
+        return count;
+    }
+
+    // feeds every started channel with ZLGCAN_MOCK_RATE frames per second, as if another node were on the bus
+    void generate(Device* device)
+    {
+        // a rate beyond the clock resolution would round the period to zero and never leave the catch up loop
+        const auto period{std::max(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>{1.0 / Settings::get().rate}), Clock::duration{1})};
+
+        std::unique_lock<std::mutex> locker{device->mutex};
+        while(!device->closing)
+        {
+            const auto now{Clock::now()};
+            auto due{now + std::chrono::milliseconds{100}};
+            auto delivered{false};
+            for(auto& channel: device->channels)
+            {
+                if(!channel.started)
+                {
+                    continue;
+                }
+                for(; channel.next_frame <= now; channel.next_frame += period)
+                {
+                    ZCANDataObj record{};
+                    if(device->fail())
+                    {
+                        record.dataType = ZCAN_DT_ZCAN_ERROR_DATA;
+                        auto& error_data{record.data.zcanErrData};
+                        error_data.timeStamp = device->now();
+                        error_data.errType = ZCAN_ERR_TYPE_BUS_ERR;
+                        error_data.errSubType = static_cast<BYTE>(std::uniform_int_distribution<int>{ZCAN_BUS_ERR_BIT_ERR, ZCAN_BUS_ERR_OVERLOAD_ERR}(device->random));
+                        error_data.nodeState = ZCAN_NODE_STATE_ACTIVE;
+                        error_data.rxErrCount = 8;
+                        channel.error_code |= ZCAN_ERROR_CAN_BUSERR;
+                    }
+                    else
+                    {
+                        record.dataType = ZCAN_DT_ZCAN_CAN_CANFD_DATA;
+                        auto& can_data{record.data.zcanCANFDData};
+                        can_data.timeStamp = device->now();
+                        can_data.frame.can_id = 0x100 + channel.index;
+                        can_data.frame.len = CAN_MAX_DLEN;
+                        std::memcpy(can_data.frame.data, &channel.sequence, CAN_MAX_DLEN);
+                        ++channel.sequence;
+                    }
+                    deliver(*device, channel, record);
+                    delivered = true;
+                }
+                due = std::min(due, channel.next_frame);
+            }
+            if(delivered)
+            {
+                device->available.notify_all();
+            }
+            device->wake.wait_until(locker, due);
+        }
+    }
+} //namespace
+
+using namespace zlg::mock;
+
+extern "C"
+{
+    DEVICE_HANDLE FUNC_CALL ZCAN_OpenDevice(UINT device_type, UINT device_index, UINT reserved)
+    {
+        (void)reserved;
+        const std::lock_guard<std::mutex> locker{devices_mutex};
+        auto& device{devices[{device_type, device_index}]};
+        if(device)
+        {
+            return INVALID_DEVICE_HANDLE;
+        }
+        device = std::make_unique<Device>();
+        device->type = device_type;
+        device->index = device_index;
+        device->channels.resize(Settings::get().channels);
+        for(auto i{0U}; i < device->channels.size(); ++i)
+        {
+            device->channels[i].device = device.get();
+            device->channels[i].index = i;
+        }
+        if(Settings::get().rate > 0.0)
+        {
+            device->generator = std::thread{generate, device.get()};
+        }
+        return device.get();
+    }
+
+    UINT FUNC_CALL ZCAN_CloseDevice(DEVICE_HANDLE device_handle)
+    {
+        auto* device{device_of(device_handle)};
+        if(!device)
+        {
+            return STATUS_ERR;
+        }
+        {
+            std::unique_lock<std::mutex> locker{device->mutex};
+            device->closing = true;
+            device->wake.notify_all();
+            device->available.notify_all();
+            device->left.wait(locker, [&]() {
+                return 0 == device->receivers;
+            });
+        }
+        if(device->generator.joinable())
+        {
+            device->generator.join();
+        }
+
+        const std::lock_guard<std::mutex> locker{devices_mutex};
+        devices.erase({device->type, device->index});
+        return STATUS_OK;
+    }
+
+    UINT FUNC_CALL ZCAN_GetDeviceInf(DEVICE_HANDLE device_handle, ZCAN_DEVICE_INFO* pInfo)
+    {
+        auto* device{device_of(device_handle)};
+        if(!device || !pInfo)
+        {
+            return STATUS_ERR;
+        }
+        std::memset(pInfo, 0, sizeof(ZCAN_DEVICE_INFO));
+        pInfo->hw_Version = 0x0100;
+        pInfo->fw_Version = 0x0100;
+        pInfo->dr_Version = 0x0100;
+        pInfo->in_Version = 0x0100;
+        pInfo->can_Num = static_cast<BYTE>(device->channels.size());
+        std::snprintf(reinterpret_cast<char*>(pInfo->str_Serial_Num), sizeof(pInfo->str_Serial_Num), "MOCK%u", device->index);
+        std::snprintf(reinterpret_cast<char*>(pInfo->str_hw_Type), sizeof(pInfo->str_hw_Type), "ZLGCAN-MOCK");
+        return STATUS_OK;
+    }
+
+    UINT FUNC_CALL ZCAN_IsDeviceOnLine(DEVICE_HANDLE device_handle)
+    {
+        auto* device{device_of(device_handle)};
+        if(!device)
+        {
+            return STATUS_OFFLINE;
+        }
+        const std::lock_guard<std::mutex> locker{device->mutex};
+        return device->unplugged ? STATUS_OFFLINE : STATUS_ONLINE;
+    }
+
+    CHANNEL_HANDLE FUNC_CALL ZCAN_InitCAN(DEVICE_HANDLE device_handle, UINT can_index, ZCAN_CHANNEL_INIT_CONFIG* pInitConfig)
+    {
+        auto* device{device_of(device_handle)};
+        if(!device || can_index >= device->channels.size())
+        {
+            return INVALID_CHANNEL_HANDLE;
+        }
+        const std::lock_guard<std::mutex> locker{device->mutex};
+        auto& channel{device->channels[can_index]};
+        channel.fd = pInitConfig && TYPE_CANFD == pInitConfig->can_type;
+        return &channel;
+    }
+
+    UINT FUNC_CALL ZCAN_StartCAN(CHANNEL_HANDLE channel_handle)
+    {
+        auto* channel{channel_of(channel_handle)};
+        if(!channel)
+        {
+            return STATUS_ERR;
+        }
+        {
+            const std::lock_guard<std::mutex> locker{channel->device->mutex};
+            if(channel->device->unplugged)
+            {
+                return STATUS_ERR;
+            }
+            channel->started = true;
+            channel->error_code = 0;
+            channel->fault_code &= ~ZCAN_ERROR_CAN_BUSOFF;
+            channel->next_frame = Clock::now();
+        }
+        channel->device->wake.notify_all();
+        return STATUS_OK;
+    }
+
+    UINT FUNC_CALL ZCAN_ResetCAN(CHANNEL_HANDLE channel_handle)
+    {
+        auto* channel{channel_of(channel_handle)};
+        if(!channel)
+        {
+            return STATUS_ERR;
+        }
+        const std::lock_guard<std::mutex> locker{channel->device->mutex};
+        if(channel->device->unplugged)
+        {
+            return STATUS_ERR;
+        }
+        channel->started = false;
+        channel->can.clear();
+        channel->canfd.clear();
+        auto& merged{channel->device->merged};
+        merged.erase(std::remove_if(merged.begin(), merged.end(), [&](const ZCANDataObj& record) {
+            return record.chnl == channel->index;
+        }), merged.end());
+        return STATUS_OK;
+    }
+
+    UINT FUNC_CALL ZCAN_ClearBuffer(CHANNEL_HANDLE channel_handle)
+    {
+        auto* channel{channel_of(channel_handle)};
+        if(!channel)
+        {
+            return STATUS_ERR;
+        }
+        const std::lock_guard<std::mutex> locker{channel->device->mutex};
+        channel->can.clear();
+        channel->canfd.clear();
+        return STATUS_OK;
+    }
+
+    UINT FUNC_CALL ZCAN_ReadChannelErrInfo(CHANNEL_HANDLE channel_handle, ZCAN_CHANNEL_ERR_INFO* pErrInfo)
+    {
+        auto* channel{channel_of(channel_handle)};
+        if(!channel || !pErrInfo)
+        {
+            return STATUS_ERR;
+        }
+        const std::lock_guard<std::mutex> locker{channel->device->mutex};
+        if(channel->device->unplugged)
+        {
+            return STATUS_ERR;
+        }
+        std::memset(pErrInfo, 0, sizeof(ZCAN_CHANNEL_ERR_INFO));
+        pErrInfo->error_code = channel->error_code | channel->fault_code;
+        channel->error_code = 0;
+        return STATUS_OK;
+    }
+
+    UINT FUNC_CALL ZCAN_ReadChannelStatus(CHANNEL_HANDLE channel_handle, ZCAN_CHANNEL_STATUS* pCANStatus)
+    {
+        if(!channel_of(channel_handle) || !pCANStatus)
+        {
+            return STATUS_ERR;
+        }
+        std::memset(pCANStatus, 0, sizeof(ZCAN_CHANNEL_STATUS));
+        return STATUS_OK;
+    }
+
+    UINT FUNC_CALL ZCAN_GetReceiveNum(CHANNEL_HANDLE channel_handle, BYTE type)
+    {
+        auto* channel{channel_of(channel_handle)};
+        if(!channel)
+        {
+            return 0;
+        }
+        const std::lock_guard<std::mutex> locker{channel->device->mutex};
+        if(channel->device->unplugged)
+        {
+            return 0;
+        }
+        switch(type)
+        {
+            case TYPE_CAN: return static_cast<UINT>(channel->can.size());
+            case TYPE_CANFD: return static_cast<UINT>(channel->canfd.size());
+            case TYPE_ALL_DATA:
+            {
+                const auto& merged{channel->device->merged};
+                return static_cast<UINT>(std::count_if(merged.begin(), merged.end(), [&](const ZCANDataObj& record) {
+                    return record.chnl == channel->index;
+                }));
+            }
+            default: return 0;
+        }
+    }
+
+    UINT FUNC_CALL ZCAN_Transmit(CHANNEL_HANDLE channel_handle, ZCAN_Transmit_Data* pTransmit, UINT len)
+    {
+        return transmit(channel_handle, pTransmit, len);
+    }
+
+    UINT FUNC_CALL ZCAN_Receive(CHANNEL_HANDLE channel_handle, ZCAN_Receive_Data* pReceive, UINT len, int wait_time)
+    {
+        auto* channel{channel_of(channel_handle)};
+        return channel ? receive(*channel->device, channel->can, pReceive, len, wait_time) : 0;
+    }
+
+    UINT FUNC_CALL ZCAN_TransmitFD(CHANNEL_HANDLE channel_handle, ZCAN_TransmitFD_Data* pTransmit, UINT len)
+    {
+        return transmit(channel_handle, pTransmit, len);
+    }
+
+    UINT FUNC_CALL ZCAN_ReceiveFD(CHANNEL_HANDLE channel_handle, ZCAN_ReceiveFD_Data* pReceive, UINT len, int wait_time)
+    {
+        auto* channel{channel_of(channel_handle)};
+        return channel ? receive(*channel->device, channel->canfd, pReceive, len, wait_time) : 0;
+    }
+
+    UINT FUNC_CALL ZCAN_TransmitData(DEVICE_HANDLE device_handle, ZCANDataObj* pTransmit, UINT len)
+    {
+        auto* device{device_of(device_handle)};
+        if(!device || !pTransmit)
+        {
+            return 0;
+        }
+        auto count{UINT{0}};
+        {
+            const std::lock_guard<std::mutex> locker{device->mutex};
+            for(; count < len; ++count)
+            {
+                const auto& record{pTransmit[count]};
+                if(ZCAN_DT_ZCAN_CAN_CANFD_DATA != record.dataType || record.chnl >= device->channels.size() || !transmit(*device, device->channels[record.chnl], record))
+                {
+                    break;
+                }
+            }
+        }
+        device->available.notify_all();
+        return count;
+    }
+
+    UINT FUNC_CALL ZCAN_ReceiveData(DEVICE_HANDLE device_handle, ZCANDataObj* pReceive, UINT len, int wait_time)
+    {
+        auto* device{device_of(device_handle)};
+        return device ? receive(*device, device->merged, pReceive, len, wait_time) : 0;
+    }
+
+    // only merged reception changes the simulation, every other path is accepted and ignored
+    UINT FUNC_CALL ZCAN_SetValue(DEVICE_HANDLE device_handle, const char* path, const void* value)
+    {
+        auto* device{device_of(device_handle)};
+        if(!device || !path)
+        {
+            return STATUS_ERR;
+        }
+        if(std::string{path}.ends_with("/set_device_recv_merge") && value)
+        {
+            const std::lock_guard<std::mutex> locker{device->mutex};
+            device->merge = '1' == *static_cast<const char*>(value);
+        }
+        return STATUS_OK;
+    }
+
+    const void* FUNC_CALL ZCAN_GetValue(DEVICE_HANDLE device_handle, const char* path)
+    {
+        (void)device_handle;
+        (void)path;
+        return nullptr;
+    }
+
+    IProperty* FUNC_CALL GetIProperty(DEVICE_HANDLE device_handle)
+    {
+        static IProperty property{
+            [](const char*, const char*) -> int {
+                return 1;
+            },
+            [](const char*) -> const char* {
+                return nullptr;
+            },
+            []() -> const ConfigNode* {
+                return nullptr;
+            },
+        };
+        return device_of(device_handle) ? &property : nullptr;
+    }
+
+    UINT FUNC_CALL ReleaseIProperty(IProperty* pIProperty)
+    {
+        return pIProperty ? STATUS_OK : STATUS_ERR;
+    }
+
+    UINT FUNC_CALL ZCAN_MOCK_InjectFault(UINT device_type, UINT device_index, UINT can_index, UINT fault)
+    {
+        // the registry lock keeps the device from being closed while the fault is injected
+        const std::lock_guard<std::mutex> devices_locker{devices_mutex};
+        const auto iter{devices.find({device_type, device_index})};
+        if(devices.end() == iter || (UnplugFault != fault && can_index >= iter->second->channels.size()))
+        {
+            return STATUS_ERR;
+        }
+        auto& device{*iter->second};
+        {
+            const std::lock_guard<std::mutex> locker{device.mutex};
+            auto node_state{[&](Channel& channel, BYTE state) {
+                ZCANDataObj record{};
+                record.dataType = ZCAN_DT_ZCAN_ERROR_DATA;
+                auto& error_data{record.data.zcanErrData};
+                error_data.timeStamp = device.now();
+                error_data.errType = ZCAN_ERR_TYPE_BUS_ERR;
+                error_data.errSubType = ZCAN_BUS_ERR_NODE_STATE_CHAGE;
+                error_data.nodeState = state;
+                error_data.rxErrCount = ZCAN_NODE_STATE_BUSOFF == state ? 255 : 128;
+                deliver(device, channel, record);
+            }};
+            switch(fault)
+            {
+                case ClearFault:
+                    if(device.unplugged)
+                    {
+                        // plugged back in: the device lost its state and every channel has to be started again
+                        device.unplugged = false;
+                        device.merged.clear();
+                        for(auto& channel: device.channels)
+                        {
+                            channel.started = false;
+                            channel.error_code = 0;
+                            channel.fault_code = 0;
+                            channel.can.clear();
+                            channel.canfd.clear();
+                        }
+                    }
+                    else
+                    {
+                        device.channels[can_index].fault_code = 0;
+                        node_state(device.channels[can_index], ZCAN_NODE_STATE_ACTIVE);
+                    }
+                    break;
+                case ErrorPassiveFault:
+                    node_state(device.channels[can_index], ZCAN_NODE_STATE_PASSIVE);
+                    device.channels[can_index].fault_code = ZCAN_ERROR_CAN_PASSIVE;
+                    break;
+                case BusOffFault:
+                    node_state(device.channels[can_index], ZCAN_NODE_STATE_BUSOFF);
+                    device.channels[can_index].fault_code = ZCAN_ERROR_CAN_BUSOFF;
+                    break;
+                case UnplugFault:
+                    device.unplugged = true;
+                    break;
+                default:
+                    return STATUS_ERR;
+            }
+        }
+        device.available.notify_all();
+        return STATUS_OK;
+    }
+}
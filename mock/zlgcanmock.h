@@ -0,0 +1,31 @@
+#ifndef ZLGCANMOCK_H
+#define ZLGCANMOCK_H
+
+#include "zlgcan/zlgcan.h"
+
+/*!
+ * Fault injection of the simulated zlgcan library, resolved at run time by the
+ * stress harness. An error passive channel keeps communicating until the fault is
+ * cleared, a bus off channel neither sends nor receives until it is restarted with
+ * ZCAN_ResetCAN/ZCAN_StartCAN. Unplugging covers the whole device: every call fails
+ * until ClearFault plugs it back in with its channels stopped.
+ */
+namespace zlg::mock
+{
+    enum Fault : unsigned int
+    {
+        ClearFault,
+        ErrorPassiveFault,
+        BusOffFault,
+        UnplugFault,
+    };
+} //namespace zlg::mock
+
+extern "C"
+{
+    typedef UINT(FUNC_CALL* pf_ZCAN_MOCK_InjectFault)(UINT device_type, UINT device_index, UINT can_index, UINT fault);
+
+    UINT FUNC_CALL ZCAN_MOCK_InjectFault(UINT device_type, UINT device_index, UINT can_index, UINT fault);
+}
+
+#endif // ZLGCANMOCK_H
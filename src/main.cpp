@@ -1,6 +1,6 @@
 #include "main.h"
 
-#include "ZLGCanBackend.h"
+#include "zlgcanbackend.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -1,10 +1,10 @@
 #include "zlgcanbackend.h"
 
 #include "zlgcanbackend_p.h"
+#include "zlgcanerror_p.h"
+#include "zlgcanprobe_p.h"
 
-#include <QFile>
 #include <QLoggingCategory>
-#include <QXmlStreamReader>
 
 QT_BEGIN_NAMESPACE
 
@@ -20,6 +20,20 @@ ZlgCanBackend::ZlgCanBackend(const QString& interfaceName, QObject* parent): QCa
         d->startWrite();
     });
 
+    connect(&d->_schedule_timer, &QTimer::timeout, this, [=]() {
+        d->refillSchedule();
+    });
+
+    connect(&d->_echo_timer, &QTimer::timeout, this, [=]() {
+        d->expireEchoes();
+    });
+
+    d->_reorder_timer.setSingleShot(true);
+    connect(&d->_reorder_timer, &QTimer::timeout, this, [=]() {
+        d->releaseOrdered(d->_clock.nsecsElapsed() / 1000, false);
+        d->flushReceived();
+    });
+
     d->setInterfaceName(interfaceName);
 
 #if(QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
@@ -111,60 +125,52 @@ bool ZlgCanBackend::writeFrame(const QCanBusFrame& frame)
     //     return false;
     // }
 
-    enqueueOutgoingFrame(frame);
-
-    if(!d->_write_timer.isActive())
-    {
-        d->_write_timer.start();
-    }
-
-    return true;
+    return d->writeFrame(frame);
 }
 
 QString ZlgCanBackend::interpretErrorFrame(const QCanBusFrame& frame)
 {
-    Q_D(ZlgCanBackend);
-    Q_UNUSED(d);
-    Q_UNUSED(frame);
-
-    return QString();
+    return zlg::error::interpret(frame);
 }
 
 QList<QCanBusDeviceInfo> ZlgCanBackend::interfaces()
 {
-    static QList<QCanBusDeviceInfo> devices_info{};
-
-    if(devices_info.empty())
+    // ZLGCAN_PROBE=<timeout in ms> lists the adapters actually connected, one interface per channel
+    static const auto probe_timeout{qEnvironmentVariableIntValue("ZLGCAN_PROBE")};
+    if(probe_timeout > 0)
     {
-        QFile file(":devices.xml");
-        if(file.open(QFile::ReadOnly))
+        QList<QCanBusDeviceInfo> devices_info{};
+        for(const auto& probed: zlg::DeviceProbe::instance()->devices(probe_timeout))
         {
-            QXmlStreamReader devices_xml_reader(&file);
-            while(devices_xml_reader.readNextStartElement())
+            const auto& device{zlg::get_device(probed.type)};
+            const auto name{QString::fromLatin1(device.name.data(), static_cast<int>(device.name.size()))};
+            for(auto channel{0U}; channel < probed.channels; ++channel)
             {
-                if(Q_UNLIKELY("Devices" != devices_xml_reader.name().toString()))
-                {
-                    break;
-                }
-                while(devices_xml_reader.readNextStartElement())
-                {
-                    if("Device" == devices_xml_reader.name().toString() && devices_xml_reader.attributes().hasAttribute("name"))
-                    {
-                        auto name = devices_xml_reader.attributes().value("name").toString();
-                        auto fd = ("TRUE" == devices_xml_reader.attributes().value("fd").toString().toUpper());
-
+                const auto interface_name{QStringLiteral("<Device type=\"%1\" index=\"%2\" channel=\"%3\" />").arg(name).arg(probed.index).arg(channel)};
 #if(QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
-                        devices_info.append(QCanBusDevice::createDeviceInfo("zlgcan", name, false, fd));
+                devices_info.append(QCanBusDevice::createDeviceInfo("zlgcan", interface_name, probed.serial_number, probed.description, QString(), static_cast<int>(channel), false, device.fd));
 #else
-                        devices_info.append(std::move(QCanBusDevice::createDeviceInfo(name, false, fd)));
+                devices_info.append(QCanBusDevice::createDeviceInfo(interface_name, probed.serial_number, probed.description, static_cast<int>(channel), false, device.fd));
 #endif
-                    }
-                    devices_xml_reader.skipCurrentElement();
-                }
             }
         }
+        return devices_info;
     }
 
+    static const QList<QCanBusDeviceInfo> devices_info{[]() {
+        QList<QCanBusDeviceInfo> devices_info{};
+        for(const auto* device: zlg::get_devices())
+        {
+            const auto name{QString::fromLatin1(device->name.data(), static_cast<int>(device->name.size()))};
+#if(QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+            devices_info.append(QCanBusDevice::createDeviceInfo("zlgcan", name, false, device->fd));
+#else
+            devices_info.append(std::move(QCanBusDevice::createDeviceInfo(name, false, device->fd)));
+#endif
+        }
+        return devices_info;
+    }()};
+
     return devices_info;
 }
 
@@ -187,4 +193,185 @@ QCanBusDevice::CanBusStatus ZlgCanBackend::busStatus()
     return d->busStatus();
 }
 
+QVector<quint64> ZlgCanBackend::receiveLatencyHistogram() const
+{
+    Q_D(const ZlgCanBackend);
+
+    return d->_latency_histogram.buckets();
+}
+
+void ZlgCanBackend::resetReceiveLatencyHistogram()
+{
+    Q_D(ZlgCanBackend);
+
+    d->_latency_histogram.reset();
+}
+
+QVector<quint64> ZlgCanBackend::transmitLatencyHistogram() const
+{
+    Q_D(const ZlgCanBackend);
+
+    return d->_tx_latency_histogram.buckets();
+}
+
+void ZlgCanBackend::resetTransmitLatencyHistogram()
+{
+    Q_D(ZlgCanBackend);
+
+    d->_tx_latency_histogram.reset();
+}
+
+ZlgCanBackend::RingStatistics ZlgCanBackend::receiveRingStatistics() const
+{
+    Q_D(const ZlgCanBackend);
+
+    RingStatistics statistics{};
+    // only the rings of the active receive path are allocated, the others report zero
+    statistics.capacity = qMax(d->_ring.capacity(), d->_data_ring.capacity());
+    statistics.highWaterMark = qMax(qMax(d->_ring.high_water_mark(), d->_fd_ring.high_water_mark()), d->_data_ring.high_water_mark());
+    statistics.overflows = d->_ring.overflows() + d->_fd_ring.overflows() + d->_data_ring.overflows();
+    return statistics;
+}
+
+bool ZlgCanBackend::scheduleFrames(const QVector<ScheduledFrame>& frames)
+{
+    Q_D(ZlgCanBackend);
+
+    if(Q_UNLIKELY(QCanBusDevice::ConnectedState != state()))
+    {
+        return false;
+    }
+
+    return d->scheduleFrames(frames);
+}
+
+void ZlgCanBackend::cancelSchedule()
+{
+    Q_D(ZlgCanBackend);
+
+    d->cancelSchedule();
+}
+
+int ZlgCanBackend::addCyclicFrame(const QCanBusFrame& frame, int interval, int startDelay)
+{
+    Q_D(ZlgCanBackend);
+
+    if(Q_UNLIKELY(QCanBusDevice::ConnectedState != state()))
+    {
+        return -1;
+    }
+
+    if(Q_UNLIKELY(!frame.isValid() || interval <= 0))
+    {
+        setError(tr("Cannot add invalid cyclic frame"), QCanBusDevice::WriteError);
+        return -1;
+    }
+
+    if(Q_UNLIKELY(QCanBusFrame::DataFrame != frame.frameType() && QCanBusFrame::RemoteRequestFrame != frame.frameType()))
+    {
+        setError(tr("Unable to add a cyclic frame with unacceptable type"), QCanBusDevice::WriteError);
+        return -1;
+    }
+
+    return d->addCyclicFrame(frame, interval, startDelay);
+}
+
+bool ZlgCanBackend::updateCyclicFrame(int id, const QByteArray& payload)
+{
+    Q_D(ZlgCanBackend);
+
+    return d->updateCyclicFrame(id, payload);
+}
+
+bool ZlgCanBackend::removeCyclicFrame(int id)
+{
+    Q_D(ZlgCanBackend);
+
+    return d->removeCyclicFrame(id);
+}
+
+void ZlgCanBackend::clearCyclicFrames()
+{
+    Q_D(ZlgCanBackend);
+
+    d->clearCyclicFrames();
+}
+
+ZlgCanBackend::ScheduleStatistics ZlgCanBackend::scheduleStatistics() const
+{
+    Q_D(const ZlgCanBackend);
+
+    return d->_schedule.statistics();
+}
+
+ZlgCanBackend::LockStatistics ZlgCanBackend::lockStatistics(LockPath path) const
+{
+    Q_D(const ZlgCanBackend);
+
+    switch(path)
+    {
+        case ReceiveLock: return d->_rx_mutex.statistics();
+        case TransmitLock: return d->_tx_mutex.statistics();
+        case ControlLock: return d->_control_mutex.statistics();
+        case DeviceTransmitLock: return d->_device_tx_mutex ? d->_device_tx_mutex->statistics() : LockStatistics{};
+        default: return LockStatistics{};
+    }
+}
+
+ZlgCanBackend::PerformanceCounters ZlgCanBackend::performanceCounters() const
+{
+    Q_D(const ZlgCanBackend);
+
+    return d->_counters.snapshot();
+}
+
+void ZlgCanBackend::resetPerformanceCounters()
+{
+    Q_D(ZlgCanBackend);
+
+    d->_counters.reset();
+}
+
+ZlgCanBackend::FilterStatistics ZlgCanBackend::filterStatistics() const
+{
+    Q_D(const ZlgCanBackend);
+
+    return {d->_filter.hits(), d->_filter.dropped()};
+}
+
+void ZlgCanBackend::resetFilterStatistics()
+{
+    Q_D(ZlgCanBackend);
+
+    d->_filter.reset_statistics();
+}
+
+bool ZlgCanBackend::dumpTrace(const QString& fileName)
+{
+#if defined(ZLGCAN_TRACE)
+    return zlg::Tracer::instance()->dump(fileName);
+#else
+    Q_UNUSED(fileName)
+    return false;
+#endif
+}
+
+ZlgCanBackend::PayloadPoolStatistics ZlgCanBackend::payloadPoolStatistics() const
+{
+    Q_D(const ZlgCanBackend);
+
+    PayloadPoolStatistics statistics{};
+    statistics.allocations = d->_payload_pool.allocations();
+    statistics.reuses = d->_payload_pool.reuses();
+    statistics.allocationsPerSecond = d->_payload_pool.allocations_per_second();
+    return statistics;
+}
+
+qint64 ZlgCanBackend::readRawFrames(const std::function<void(std::span<const RawFrame>)>& visitor)
+{
+    Q_D(ZlgCanBackend);
+
+    return d->readRawFrames(visitor);
+}
+
 QT_END_NAMESPACE
@@ -6,6 +6,9 @@
 #include <QCanBusFrame>
 #include <QList>
 #include <QString>
+#include <QVector>
+#include <functional>
+#include <span>
 
 QT_BEGIN_NAMESPACE
 
@@ -18,9 +21,197 @@ class ZlgCanBackend: public QCanBusDevice
     Q_DISABLE_COPY(ZlgCanBackend)
 
 public:
+    enum ZlgConfigurationKey
+    {
+        ReceiveModeKey = QCanBusDevice::UserKey,
+        ReceiveWaitTimeKey,
+        ReceiveRingCapacityKey,
+        RawFrameModeKey,
+        PayloadPoolSizeKey,
+        MergeReceiveKey,
+        ReorderWindowKey,
+        TransmitDataKey,
+        TransmitModeKey,
+        TransmitQueueCapacityKey,
+        TransmitTimeoutKey,
+        ScheduleLeadTimeKey,
+        PollIntervalMinKey,
+        PollIntervalMaxKey,
+    };
+
+    enum ReceiveMode
+    {
+        TimerReceiveMode,
+        ThreadReceiveMode,
+        AdaptiveTimerReceiveMode,
+    };
+
+    enum TransmitMode
+    {
+        TimerTransmitMode,
+        ThreadTransmitMode,
+    };
+
+    enum RawFrameFlag : quint8
+    {
+        RawExtendedFrame = 0x01,
+        RawRemoteRequest = 0x02,
+        RawErrorFrame = 0x04,
+        RawFlexibleDataRate = 0x08,
+        RawBitrateSwitch = 0x10,
+        RawErrorStateIndicator = 0x20,
+    };
+
+    // compact received frame, delivered instead of QCanBusFrame when RawFrameModeKey is true
+    struct RawFrame
+    {
+        quint64 timestamp;
+        quint32 id;
+        quint8 flags;
+        quint8 length;
+        quint8 reserved[2];
+        quint8 payload[64];
+    };
+
+    struct RingStatistics
+    {
+        quint64 capacity{0};
+        quint64 highWaterMark{0};
+        quint64 overflows{0};
+    };
+
+    struct PayloadPoolStatistics
+    {
+        quint64 allocations{0};
+        quint64 reuses{0};
+        quint64 allocationsPerSecond{0};
+    };
+
+    enum LockPath
+    {
+        ReceiveLock,
+        TransmitLock,
+        ControlLock,
+        // ZCAN_TransmitData of every channel on the adapter, the statistics are the adapter's
+        DeviceTransmitLock,
+    };
+
+    enum VendorFunction
+    {
+        ReceiveFunction,
+        ReceiveFDFunction,
+        ReceiveDataFunction,
+        GetReceiveNumFunction,
+        TransmitFunction,
+        TransmitFDFunction,
+        TransmitDataFunction,
+        ReadChannelErrInfoFunction,
+        VendorFunctionCount,
+    };
+
+    // wait time in ns, only contended acquisitions wait
+    struct LockStatistics
+    {
+        quint64 acquisitions{0};
+        quint64 contentions{0};
+        quint64 waitTime{0};
+    };
+
+    // send time in us, relative to the first frame of the schedule
+    struct ScheduledFrame
+    {
+        QCanBusFrame frame{};
+        quint64 time{0};
+    };
+
+    // drift in us, measured from tx echoes when available, otherwise from frames handed to the device too late
+    struct ScheduleStatistics
+    {
+        quint64 queued{0};
+        quint64 sent{0};
+        quint64 underruns{0};
+        qint64 maxDrift{0};
+        qint64 meanDrift{0};
+    };
+
+    // time in ns, including the time a blocking call waited for records
+    struct VendorCallStatistics
+    {
+        quint64 calls{0};
+        quint64 time{0};
+    };
+
+    // hits count the frames passed by each RawFilterKey filter, a frame only counts for the first filter it matches
+    struct FilterStatistics
+    {
+        QVector<quint64> hits{};
+        quint64 dropped{0};
+    };
+
+    // batch bucket n counts non-empty vendor batches of 2^n to 2^(n+1) - 1 frames, the last bucket everything above
+    struct PerformanceCounters
+    {
+        quint64 framesReceived{0};
+        quint64 bytesReceived{0};
+        quint64 framesTransmitted{0};
+        quint64 bytesTransmitted{0};
+        // overflows in ZCAN_CHANNEL_ERR_INFO, sampled every 100 ms while the channel is read, or in merged error records
+        quint64 bufferOverflows{0};
+        quint64 rawFramesDropped{0};
+        quint64 enqueueCalls{0};
+        quint64 enqueueTime{0};
+        VendorCallStatistics vendorCalls[VendorFunctionCount]{};
+        QVector<quint64> receiveBatchSizes{};
+        QVector<quint64> transmitBatchSizes{};
+    };
+
     explicit ZlgCanBackend(const QString& interfaceName, QObject* parent = nullptr);
     ~ZlgCanBackend();
 
+    // bucket n counts frames whose receive latency is below 2^n us (and at least 2^(n-1) us)
+    QVector<quint64> receiveLatencyHistogram() const;
+    void resetReceiveLatencyHistogram();
+
+    // bucket n counts echoed frames whose transmit latency is below 2^n us, measured from ZCAN_TransmitData to the hardware echo
+    QVector<quint64> transmitLatencyHistogram() const;
+    void resetTransmitLatencyHistogram();
+
+    // raw receive rings of ThreadReceiveMode (CAN and CAN FD combined) or of merged reception
+    RingStatistics receiveRingStatistics() const;
+
+    // payload buffers of received QCanBusFrames, recycled once all copies of a frame are released
+    PayloadPoolStatistics payloadPoolStatistics() const;
+
+    // replays frames through the device's delayed send queue, refilled ScheduleLeadTimeKey us ahead of playback;
+    // not available with ThreadTransmitMode while tx echo is on
+    bool scheduleFrames(const QVector<ScheduledFrame>& frames);
+    void cancelSchedule();
+    ScheduleStatistics scheduleStatistics() const;
+
+    // periodic frames run on the device's auto_send objects when it has them, otherwise on a host thread; interval and delay in ms
+    int addCyclicFrame(const QCanBusFrame& frame, int interval, int startDelay = 0);
+    bool updateCyclicFrame(int id, const QByteArray& payload);
+    bool removeCyclicFrame(int id);
+    void clearCyclicFrames();
+
+    // vendor calls are serialized per path, see zlgcanlock_p.h for which calls share a path
+    LockStatistics lockStatistics(LockPath path) const;
+
+    // cheap atomic counters of the receive and transmit paths, safe to read from any thread
+    PerformanceCounters performanceCounters() const;
+    void resetPerformanceCounters();
+
+    // frames reaching the host after any hardware filtering; updated on the device's thread and restarted when RawFilterKey changes
+    FilterStatistics filterStatistics() const;
+    void resetFilterStatistics();
+
+    // writes the recorded startRead/startWrite events as Chrome trace JSON; false unless built with ZLGCAN_TRACE
+    static bool dumpTrace(const QString& fileName);
+
+    // visits every pending raw batch in arrival order; the spans are only valid inside the visitor
+    // at most ReceiveRingCapacityKey frames wait for it, newer ones are counted in rawFramesDropped
+    qint64 readRawFrames(const std::function<void(std::span<const RawFrame>)>& visitor);
+
     virtual bool open() override;
     virtual void close() override;
 
@@ -53,6 +244,9 @@ private:
     // virtual QCanBusDeviceInfo deviceInfo() const override;
 #endif
 
+signals:
+    void rawFramesReceived();
+
 private:
     ZlgCanBackendPrivate* const d_ptr{nullptr};
 };
@@ -1,10 +1,15 @@
 #include "zlgcanbackend_p.h"
 
 #include "zlgcanbackend.h"
+#include "zlgcanerror_p.h"
+#include "zlgcancyclic_p.h"
+#include "zlgcanreceiver_p.h"
+#include "zlgcanregistry_p.h"
+#include "zlgcantransmitter_p.h"
 
-#include <QFile>
 #include <QLoggingCategory>
 #include <QXmlStreamReader>
+#include <bit>
 
 QT_BEGIN_NAMESPACE
 
@@ -12,250 +17,307 @@ Q_DECLARE_LOGGING_CATEGORY(QT_CANBUS_PLUGINS_ZLGCAN)
 
 namespace zlg
 {
-    const QHash<unsigned int, Device>& get_devices()
-    {
-        static QHash<unsigned int, Device> devices{};
-
-        if(devices.empty())
-        {
-            QFile file(":devices.xml");
-            if(file.open(QFile::ReadOnly))
-            {
-                QXmlStreamReader devices_xml_reader(&file);
-
-                auto read_bitrate = [](QXmlStreamReader& xml, QSet<unsigned int>& bitRate) {
-                    while(xml.readNextStartElement())
-                    {
-                        if("VALUE" == xml.name().toString().toUpper())
-                        {
-                            auto value{xml.readElementText().toUInt()};
-                            if(value)
-                            {
-                                bitRate << value;
-                            }
-                        }
-                    }
-                };
-
-                auto read_key = [](QXmlStreamReader& xml, Configuration& configuration) {
-                    configuration.configurable = ("TRUE" == xml.attributes().value("configurable").toString().toUpper());
-
-                    if("ZCAN_INITCAN" == xml.attributes().value("method").toString().toUpper())
-                    {
-                        configuration.function = ConfigureFunction::ZCAN_INITCAN;
-                    }
-                    else if("ZCAN_SETVALUE" == xml.attributes().value("method").toString().toUpper())
-                    {
-                        configuration.function = ConfigureFunction::ZCAN_SETVALUE;
-                    }
-                    else if("IPROPERTY_SETVALUE" == xml.attributes().value("method").toString().toUpper())
-                    {
-                        configuration.function = ConfigureFunction::IPROPERTY_SETVALUE;
-                    }
-
-                    if("BEFORE_INIT_CAN" == xml.attributes().value("sequence").toString().toUpper())
-                    {
-                        configuration.order = ConfigureOrder::BEFORE_INIT_CAN;
-                    }
-                    else if("BEFORE_START_CAN" == xml.attributes().value("sequence").toString().toUpper())
-                    {
-                        configuration.order = ConfigureOrder::BEFORE_START_CAN;
-                    }
-                    else if("AFTER_START_CAN" == xml.attributes().value("sequence").toString().toUpper())
-                    {
-                        configuration.order = ConfigureOrder::AFTER_START_CAN;
-                    }
-                };
-
-                auto read_configuration = [&](Device& device) {
-                    while(devices_xml_reader.readNextStartElement())
-                    {
-                        if(devices_xml_reader.attributes().hasAttribute("configurable") && ("FALSE" == devices_xml_reader.attributes().value("configurable").toString().toUpper()))
-                        {
-                            devices_xml_reader.skipCurrentElement();
-                            continue;
-                        }
-
-                        auto keyName{devices_xml_reader.name().toString().toUpper()};
-                        if("RAWFILTE" == keyName)
-                        {
-                            auto& configuration = device.configurations[QCanBusDevice::RawFilterKey];
-                            configuration.key = QCanBusDevice::RawFilterKey;
-                            read_key(devices_xml_reader, configuration);
-                            devices_xml_reader.skipCurrentElement();
-                        }
-                        else if("ERRORFILTER" == keyName)
-                        {
-                            auto& configuration = device.configurations[QCanBusDevice::ErrorFilterKey];
-                            configuration.key = QCanBusDevice::ErrorFilterKey;
-                            read_key(devices_xml_reader, configuration);
-                            devices_xml_reader.skipCurrentElement();
-                        }
-                        else if("LOOPBACK" == keyName)
-                        {
-                            auto& configuration = device.configurations[QCanBusDevice::LoopbackKey];
-                            configuration.key = QCanBusDevice::LoopbackKey;
-                            read_key(devices_xml_reader, configuration);
-                            devices_xml_reader.skipCurrentElement();
-                        }
-                        else if("RECEIVEOWN" == keyName)
-                        {
-                            auto& configuration = device.configurations[QCanBusDevice::ReceiveOwnKey];
-                            configuration.key = QCanBusDevice::ReceiveOwnKey;
-                            read_key(devices_xml_reader, configuration);
-                            devices_xml_reader.skipCurrentElement();
-                        }
-                        else if("BITRATE" == keyName)
-                        {
-                            auto& configuration = device.configurations[QCanBusDevice::BitRateKey];
-                            configuration.key = QCanBusDevice::BitRateKey;
-                            read_key(devices_xml_reader, configuration);
-                            read_bitrate(devices_xml_reader, device.bitrate);
-                            // devicesXml.skipCurrentElement();
-                        }
-                        else if("CANFD" == keyName)
-                        {
-                            auto& configuration = device.configurations[QCanBusDevice::CanFdKey];
-                            configuration.key = QCanBusDevice::CanFdKey;
-                            read_key(devices_xml_reader, configuration);
-                            devices_xml_reader.skipCurrentElement();
-                        }
-                        else if("DATABITRATE" == keyName)
-                        {
-                            auto& configuration = device.configurations[QCanBusDevice::DataBitRateKey];
-                            configuration.key = QCanBusDevice::DataBitRateKey;
-                            read_key(devices_xml_reader, configuration);
-                            read_bitrate(devices_xml_reader, device.data_field_bitrate);
-                            // devicesXml.skipCurrentElement();
-                        }
-                    }
-                };
-
-                auto read_configurations = [&](Device& device) {
-                    while(devices_xml_reader.readNextStartElement())
-                    {
-                        if("CONFIGURATIONS" == devices_xml_reader.name().toString().toUpper())
-                        {
-                            read_configuration(device);
-                        }
-                        else
-                        {
-                            devices_xml_reader.skipCurrentElement();
-                        }
-                    }
-                };
-
-                auto read_device = [&](Device& device) {
-                    device.name = devices_xml_reader.attributes().value("name").toString().toUpper();
-                    device.type = devices_xml_reader.attributes().value("type").toUInt();
-                    device.fd = ("TRUE" == devices_xml_reader.attributes().value("fd").toLatin1().toUpper());
-                    device.channels = devices_xml_reader.attributes().value("channels").toUInt();
-                    read_configurations(device);
-                };
-
-                auto readDevices = [&](QHash<unsigned int, Device>& devices) {
-                    while(devices_xml_reader.readNextStartElement())
-                    {
-                        if("DEVICES" == devices_xml_reader.name().toString().toUpper())
-                        {
-                            while(devices_xml_reader.readNextStartElement())
-                            {
-                                if("DEVICE" == devices_xml_reader.name().toString().toUpper())
-                                {
-                                    Device device{};
-                                    read_device(device);
-                                    devices[device.type] = device;
-                                }
-                                else
-                                {
-                                    devices_xml_reader.skipCurrentElement();
-                                }
-                            }
-                        }
-                        else
-                        {
-                            devices_xml_reader.skipCurrentElement();
-                            // return;
-                        }
-                    }
-                };
-
-                readDevices(devices);
-            }
-        }
-        return devices;
-    }
-
-    unsigned int get_device_type(QString device_name)
-    {
-        static QHash<QString, unsigned int> dict{};
-        if(dict.empty())
-        {
-            auto& devices{get_devices()};
-            for(auto& item: devices)
-            {
-                dict[item.name] = item.type;
-            }
-        }
-        device_name = device_name.toUpper();
-        if(dict.contains(device_name))
-        {
-            return dict[device_name];
-        }
-        return 0;
+    void LatencyHistogram::record(quint64 timestamp, qint64 now)
+    {
+        // device timestamps run on their own clock, so latency is measured against the smallest offset seen
+        auto offset{now - static_cast<qint64>(timestamp)};
+        if(offset < _offset)
+        {
+            _offset = offset;
+        }
+        auto bucket{std::bit_width(static_cast<quint64>(offset - _offset))};
+        ++_buckets[bucket < size ? bucket : size - 1];
+    }
+
+    QVector<quint64> LatencyHistogram::buckets() const
+    {
+        return QVector<quint64>(std::begin(_buckets), std::end(_buckets));
+    }
+
+    void LatencyHistogram::reset()
+    {
+        std::fill(std::begin(_buckets), std::end(_buckets), 0);
+        _offset = std::numeric_limits<qint64>::max();
+    }
+
+    bool accept(const ZCAN_Receive_Data&, unsigned int)
+    {
+        return true;
+    }
+
+    bool accept(const ZCAN_ReceiveFD_Data&, unsigned int)
+    {
+        return true;
+    }
+
+    bool accept(const ZCANDataObj& data, unsigned int channel)
+    {
+        return channel == data.chnl && (ZCAN_DT_ZCAN_CAN_CANFD_DATA == data.dataType || ZCAN_DT_ZCAN_ERROR_DATA == data.dataType);
+    }
+
+    UINT64 timestamp_of(const ZCAN_Receive_Data& data)
+    {
+        return data.timestamp;
+    }
+
+    UINT64 timestamp_of(const ZCAN_ReceiveFD_Data& data)
+    {
+        return data.timestamp;
+    }
+
+    UINT64 timestamp_of(const ZCANDataObj& data)
+    {
+        return ZCAN_DT_ZCAN_ERROR_DATA == data.dataType ? data.data.zcanErrData.timeStamp : data.data.zcanCANFDData.timeStamp;
+    }
+
+    void to_frame(const ZCAN_Receive_Data& data, QCanBusFrame& frame, PayloadPool& pool)
+    {
+        frame.setFrameId(GET_ID(data.frame.can_id));
+        frame.setPayload(pool.acquire(data.frame.data, qMin(int(data.frame.can_dlc), CAN_MAX_DLEN)));
+        frame.setFlexibleDataRateFormat(false);
+        frame.setBitrateSwitch(false);
+        frame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(data.timestamp));
+        frame.setExtendedFrameFormat(IS_EFF(data.frame.can_id));
+        if(IS_ERR(data.frame.can_id))
+        {
+            frame.setFrameType(QCanBusFrame::ErrorFrame);
+        }
+        else if(IS_RTR(data.frame.can_id))
+        {
+            frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+        }
+        else
+        {
+            frame.setFrameType(QCanBusFrame::DataFrame);
+        }
+    }
+
+    void to_frame(const ZCAN_ReceiveFD_Data& data, QCanBusFrame& frame, PayloadPool& pool)
+    {
+        frame.setFrameId(GET_ID(data.frame.can_id));
+        frame.setPayload(pool.acquire(data.frame.data, qMin(int(data.frame.len), CANFD_MAX_DLEN)));
+        frame.setFlexibleDataRateFormat(true);
+        frame.setBitrateSwitch(data.frame.flags & CANFD_BRS);
+        frame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(data.timestamp));
+        frame.setExtendedFrameFormat(IS_EFF(data.frame.can_id));
+        if(IS_ERR(data.frame.can_id))
+        {
+            frame.setFrameType(QCanBusFrame::ErrorFrame);
+        }
+        else
+        {
+            frame.setFrameType(QCanBusFrame::DataFrame);
+        }
+    }
+
+    void to_frame(const ZCANDataObj& data, QCanBusFrame& frame, PayloadPool& pool)
+    {
+        if(ZCAN_DT_ZCAN_ERROR_DATA == data.dataType)
+        {
+            to_frame(data.data.zcanErrData, frame);
+            return;
+        }
+
+        const auto& can_data{data.data.zcanCANFDData};
+        const auto fd{1 == can_data.flag.unionVal.frameType};
+        frame.setFrameId(GET_ID(can_data.frame.can_id));
+        frame.setPayload(pool.acquire(can_data.frame.data, qMin(int(can_data.frame.len), fd ? CANFD_MAX_DLEN : CAN_MAX_DLEN)));
+        frame.setFlexibleDataRateFormat(fd);
+        frame.setBitrateSwitch(fd && (can_data.frame.flags & CANFD_BRS));
+        frame.setLocalEcho(can_data.flag.unionVal.txEchoed);
+        frame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(can_data.timeStamp));
+        frame.setExtendedFrameFormat(IS_EFF(can_data.frame.can_id));
+        if(IS_ERR(can_data.frame.can_id))
+        {
+            frame.setFrameType(QCanBusFrame::ErrorFrame);
+        }
+        else if(!fd && IS_RTR(can_data.frame.can_id))
+        {
+            frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+        }
+        else
+        {
+            frame.setFrameType(QCanBusFrame::DataFrame);
+        }
+    }
+
+    ZlgCanBackend::RawFrame to_raw_frame(const ZCAN_Receive_Data& data)
+    {
+        ZlgCanBackend::RawFrame frame{};
+        frame.timestamp = data.timestamp;
+        frame.id = GET_ID(data.frame.can_id);
+        frame.flags = (IS_EFF(data.frame.can_id) ? ZlgCanBackend::RawExtendedFrame : 0)
+            | (IS_RTR(data.frame.can_id) ? ZlgCanBackend::RawRemoteRequest : 0)
+            | (IS_ERR(data.frame.can_id) ? ZlgCanBackend::RawErrorFrame : 0);
+        frame.length = data.frame.can_dlc > CAN_MAX_DLEN ? CAN_MAX_DLEN : data.frame.can_dlc;
+        ::memcpy(frame.payload, data.frame.data, CAN_MAX_DLEN);
+        return frame;
+    }
+
+    ZlgCanBackend::RawFrame to_raw_frame(const ZCAN_ReceiveFD_Data& data)
+    {
+        ZlgCanBackend::RawFrame frame{};
+        frame.timestamp = data.timestamp;
+        frame.id = GET_ID(data.frame.can_id);
+        frame.flags = ZlgCanBackend::RawFlexibleDataRate
+            | (IS_EFF(data.frame.can_id) ? ZlgCanBackend::RawExtendedFrame : 0)
+            | (IS_ERR(data.frame.can_id) ? ZlgCanBackend::RawErrorFrame : 0)
+            | ((data.frame.flags & CANFD_BRS) ? ZlgCanBackend::RawBitrateSwitch : 0)
+            | ((data.frame.flags & CANFD_ESI) ? ZlgCanBackend::RawErrorStateIndicator : 0);
+        frame.length = data.frame.len > CANFD_MAX_DLEN ? CANFD_MAX_DLEN : data.frame.len;
+        ::memcpy(frame.payload, data.frame.data, frame.length);
+        return frame;
+    }
+
+    ZlgCanBackend::RawFrame to_raw_frame(const error::Frame& error_frame, UINT64 timestamp)
+    {
+        ZlgCanBackend::RawFrame frame{};
+        frame.timestamp = timestamp;
+        frame.id = int(error_frame.error_class);
+        frame.flags = ZlgCanBackend::RawErrorFrame;
+        frame.length = error::payload_size;
+        ::memcpy(frame.payload, error_frame.payload, error::payload_size);
+        return frame;
+    }
+
+    ZlgCanBackend::RawFrame to_raw_frame(const ZCANDataObj& data)
+    {
+        if(ZCAN_DT_ZCAN_ERROR_DATA == data.dataType)
+        {
+            return to_raw_frame(error::from(data.data.zcanErrData), data.data.zcanErrData.timeStamp);
+        }
+
+        ZlgCanBackend::RawFrame frame{};
+        const auto& can_data{data.data.zcanCANFDData};
+        const auto fd{1 == can_data.flag.unionVal.frameType};
+        frame.timestamp = can_data.timeStamp;
+        frame.id = GET_ID(can_data.frame.can_id);
+        frame.flags = (fd ? ZlgCanBackend::RawFlexibleDataRate : 0)
+            | (IS_EFF(can_data.frame.can_id) ? ZlgCanBackend::RawExtendedFrame : 0)
+            | (!fd && IS_RTR(can_data.frame.can_id) ? ZlgCanBackend::RawRemoteRequest : 0)
+            | (IS_ERR(can_data.frame.can_id) ? ZlgCanBackend::RawErrorFrame : 0)
+            | (fd && (can_data.frame.flags & CANFD_BRS) ? ZlgCanBackend::RawBitrateSwitch : 0)
+            | (fd && (can_data.frame.flags & CANFD_ESI) ? ZlgCanBackend::RawErrorStateIndicator : 0);
+        frame.length = qMin(int(can_data.frame.len), fd ? CANFD_MAX_DLEN : CAN_MAX_DLEN);
+        ::memcpy(frame.payload, can_data.frame.data, frame.length);
+        return frame;
     }
 
     Loader::Loader()
     {
-        if(!(_handle = LoadLibraryA("zlgcan.dll")))
-        {
-            qCCritical(QT_CANBUS_PLUGINS_ZLGCAN, "Cannot load library: %ls", qUtf16Printable("zlgcan.dll"));
-            // throw std::runtime_error("Load library \"zlgcan.dll\" failed.");
-        }
-
-        ZCAN_OpenDevice = (pf_ZCAN_OpenDevice)GetProcAddress(_handle, "ZCAN_OpenDevice");
-        ZCAN_CloseDevice = (pf_ZCAN_CloseDevice)GetProcAddress(_handle, "ZCAN_CloseDevice");
-        ZCAN_GetDeviceInf = (pf_ZCAN_GetDeviceInf)GetProcAddress(_handle, "ZCAN_GetDeviceInf");
-        ZCAN_IsDeviceOnLine = (pf_ZCAN_IsDeviceOnLine)GetProcAddress(_handle, "ZCAN_IsDeviceOnLine");
-        ZCAN_InitCAN = (pf_ZCAN_InitCAN)GetProcAddress(_handle, "ZCAN_InitCAN");
-        ZCAN_StartCAN = (pf_ZCAN_StartCAN)GetProcAddress(_handle, "ZCAN_StartCAN");
-        ZCAN_ResetCAN = (pf_ZCAN_ResetCAN)GetProcAddress(_handle, "ZCAN_ResetCAN");
-        ZCAN_ClearBuffer = (pf_ZCAN_ClearBuffer)GetProcAddress(_handle, "ZCAN_ClearBuffer");
-        ZCAN_ReadChannelErrInfo = (pf_ZCAN_ReadChannelErrInfo)GetProcAddress(_handle, "ZCAN_ReadChannelErrInfo");
-        ZCAN_ReadChannelStatus = (pf_ZCAN_ReadChannelStatus)GetProcAddress(_handle, "ZCAN_ReadChannelStatus");
-        ZCAN_GetReceiveNum = (pf_ZCAN_GetReceiveNum)GetProcAddress(_handle, "ZCAN_GetReceiveNum");
-        ZCAN_Transmit = (pf_ZCAN_Transmit)GetProcAddress(_handle, "ZCAN_Transmit");
-        ZCAN_Receive = (pf_ZCAN_Receive)GetProcAddress(_handle, "ZCAN_Receive");
-        ZCAN_TransmitFD = (pf_ZCAN_TransmitFD)GetProcAddress(_handle, "ZCAN_TransmitFD");
-        ZCAN_ReceiveFD = (pf_ZCAN_ReceiveFD)GetProcAddress(_handle, "ZCAN_ReceiveFD");
-        ZCAN_TransmitData = (pf_ZCAN_TransmitData)GetProcAddress(_handle, "ZCAN_TransmitData");
-        ZCAN_ReceiveData = (pf_ZCAN_ReceiveData)GetProcAddress(_handle, "ZCAN_ReceiveData");
-        ZCAN_SetValue = (pf_ZCAN_SetValue)GetProcAddress(_handle, "ZCAN_SetValue");
-        ZCAN_GetValue = (pf_ZCAN_GetValue)GetProcAddress(_handle, "ZCAN_GetValue");
-        GetIProperty = (pf_GetIProperty)GetProcAddress(_handle, "GetIProperty");
-        ReleaseIProperty = (pf_ReleaseIProperty)GetProcAddress(_handle, "ReleaseIProperty");
-        ZCLOUD_SetServerInfo = (pf_ZCLOUD_SetServerInfo)GetProcAddress(_handle, "ZCLOUD_SetServerInfo");
-        ZCLOUD_ConnectServer = (pf_ZCLOUD_ConnectServer)GetProcAddress(_handle, "ZCLOUD_ConnectServer");
-        ZCLOUD_IsConnected = (pf_ZCLOUD_IsConnected)GetProcAddress(_handle, "ZCLOUD_IsConnected");
-        ZCLOUD_DisconnectServer = (pf_ZCLOUD_DisconnectServer)GetProcAddress(_handle, "ZCLOUD_DisconnectServer");
-        ZCLOUD_GetUserData = (pf_ZCLOUD_GetUserData)GetProcAddress(_handle, "ZCLOUD_GetUserData");
-        ZCLOUD_ReceiveGPS = (pf_ZCLOUD_ReceiveGPS)GetProcAddress(_handle, "ZCLOUD_ReceiveGPS");
-        ZCAN_InitLIN = (pf_ZCAN_InitLIN)GetProcAddress(_handle, "ZCAN_InitLIN");
-        ZCAN_StartLIN = (pf_ZCAN_StartLIN)GetProcAddress(_handle, "ZCAN_StartLIN");
-        ZCAN_ResetLIN = (pf_ZCAN_ResetLIN)GetProcAddress(_handle, "ZCAN_ResetLIN");
-        ZCAN_TransmitLIN = (pf_ZCAN_TransmitLIN)GetProcAddress(_handle, "ZCAN_TransmitLIN");
-        ZCAN_GetLINReceiveNum = (pf_ZCAN_GetLINReceiveNum)GetProcAddress(_handle, "ZCAN_GetLINReceiveNum");
-        ZCAN_ReceiveLIN = (pf_ZCAN_ReceiveLIN)GetProcAddress(_handle, "ZCAN_ReceiveLIN");
-        ZCAN_SetLINSlaveMsg = (pf_ZCAN_SetLINSlaveMsg)GetProcAddress(_handle, "ZCAN_SetLINSlaveMsg");
-        ZCAN_ClearLINSlaveMsg = (pf_ZCAN_ClearLINSlaveMsg)GetProcAddress(_handle, "ZCAN_ClearLINSlaveMsg");
+        // QLibrary maps the name to zlgcan.dll on Windows and libzlgcan.so elsewhere, see LoadLibrary and dlopen
+        _library.setFileName("zlgcan");
+    }
+
+    QFunctionPointer Loader::resolve(const char* name) const
+    {
+        const QMutexLocker locker{&_mutex};
+
+        // the library is loaded by the first entry point called, and only tried once
+        if(!_load_tried)
+        {
+            _load_tried = true;
+            if(!_library.load())
+            {
+                qCCritical(QT_CANBUS_PLUGINS_ZLGCAN, "Cannot load library: %ls", qUtf16Printable(_library.errorString()));
+            }
+        }
+        if(!_library.isLoaded())
+        {
+            return nullptr;
+        }
+
+        const auto function{_library.resolve(name)};
+        if(!function)
+        {
+            qCWarning(QT_CANBUS_PLUGINS_ZLGCAN, "Cannot resolve %s: %ls", name, qUtf16Printable(_library.errorString()));
+        }
+        return function;
     }
 
     Loader::~Loader()
     {
-        if(_handle)
+        if(_library.isLoaded())
+        {
+            _library.unload();
+        }
+    }
+
+    const QString& error_string(unsigned int error_code)
+    {
+        static QHash<unsigned int, QString> dict{
+            {                             0,                "Unknown error"},
+            {       ZCAN_ERROR_CAN_OVERFLOW, "CAN controller FIFO overflow"},
+            {       ZCAN_ERROR_CAN_ERRALARM,         "CAN controller alarm"},
+            {        ZCAN_ERROR_CAN_PASSIVE,       "CAN controller passive"},
+            {           ZCAN_ERROR_CAN_LOSE,          "CAN controller lose"},
+            {         ZCAN_ERROR_CAN_BUSERR,     "CAN controller bus error"},
+            {         ZCAN_ERROR_CAN_BUSOFF,       "CAN controller bus off"},
+            {ZCAN_ERROR_CAN_BUFFER_OVERFLOW,          "CAN buffer overflow"},
+            {       ZCAN_ERROR_DEVICEOPENED,                "Device opened"},
+            {         ZCAN_ERROR_DEVICEOPEN,            "Open device error"},
+            {      ZCAN_ERROR_DEVICENOTOPEN,    "The buffer cannot be read"},
+            {     ZCAN_ERROR_BUFFEROVERFLOW,              "Buffer overflow"},
+            {     ZCAN_ERROR_DEVICENOTEXIST,             "Device not exist"},
+            {      ZCAN_ERROR_LOADKERNELDLL,        "Load kernel dll error"},
+            {          ZCAN_ERROR_CMDFAILED,            "Run command error"},
+            {       ZCAN_ERROR_BUFFERCREATE,          "Create buffer error"},
+            {       ZCAN_ERROR_SEND_PARTIAL,       "Frames partially sent"},
+            {      ZCAN_ERROR_SEND_TOO_FAST,       "Frames sent too fast"},
+        };
+
+        if(dict.contains(error_code))
         {
-            FreeLibrary(_handle);
+            return dict[error_code];
         }
+        return dict[0];
+    }
+
+    void to_transmit_data(const QCanBusFrame& frame, ZCAN_Transmit_Data& data)
+    {
+        const auto payload{frame.payload()};
+        ::memset(&data, 0, sizeof(ZCAN_Transmit_Data));
+        data.frame.can_id = MAKE_CAN_ID(frame.frameId(), frame.hasExtendedFrameFormat(), frame.frameType() == QCanBusFrame::RemoteRequestFrame, frame.frameType() == QCanBusFrame::ErrorFrame);
+        data.frame.can_dlc = payload.size();
+        ::memcpy(data.frame.data, payload, qMin<std::size_t>(sizeof(ZCAN_Transmit_Data::frame.data), payload.size()));
+    }
+
+    void to_transmit_data(const QCanBusFrame& frame, ZCAN_TransmitFD_Data& data)
+    {
+        const auto payload{frame.payload()};
+        ::memset(&data, 0, sizeof(ZCAN_TransmitFD_Data));
+        data.frame.can_id = MAKE_CAN_ID(frame.frameId(), frame.hasExtendedFrameFormat(), frame.frameType() == QCanBusFrame::RemoteRequestFrame, frame.frameType() == QCanBusFrame::ErrorFrame);
+        data.frame.flags |= frame.hasBitrateSwitch() ? CANFD_BRS : 0;
+        data.frame.len = payload.size();
+        ::memcpy(data.frame.data, payload, qMin<std::size_t>(sizeof(ZCAN_TransmitFD_Data::frame.data), payload.size()));
+    }
+
+    void to_transmit_data(const QCanBusFrame& frame, unsigned int channel, bool echo, ZCANDataObj& data)
+    {
+        const auto payload{frame.payload()};
+        ::memset(&data, 0, sizeof(ZCANDataObj));
+        data.dataType = ZCAN_DT_ZCAN_CAN_CANFD_DATA;
+        data.chnl = channel;
+        auto& can_data{data.data.zcanCANFDData};
+        can_data.flag.unionVal.frameType = frame.hasFlexibleDataRateFormat() ? 1 : 0;
+        can_data.flag.unionVal.txEchoRequest = echo ? 1 : 0;
+        can_data.frame.can_id = MAKE_CAN_ID(frame.frameId(), frame.hasExtendedFrameFormat(), frame.frameType() == QCanBusFrame::RemoteRequestFrame, frame.frameType() == QCanBusFrame::ErrorFrame);
+        can_data.frame.flags |= frame.hasBitrateSwitch() ? CANFD_BRS : 0;
+        can_data.frame.len = payload.size();
+        ::memcpy(can_data.frame.data, payload, qMin<std::size_t>(sizeof(can_data.frame.data), payload.size()));
+    }
+
+    void set_echo_tag(ZCANDataObj& data, quint32& sequence)
+    {
+        sequence = sequence + 1 ? sequence + 1 : 1;
+        ::memcpy(data.data.zcanCANFDData.extraData, &sequence, sizeof(sequence));
+    }
+
+    quint32 echo_tag(const ZCANDataObj& data)
+    {
+        auto tag{quint32{0}};
+        ::memcpy(&tag, data.data.zcanCANFDData.extraData, sizeof(tag));
+        return tag;
     }
 
     const Loader* Loader::instance()
@@ -264,11 +326,81 @@ namespace zlg
         return &instance;
     }
 
+    bool ChannelErrors::read(Reader reader, const Loader* dll, CHANNEL_HANDLE channel_handle, PerformanceCounters& counters, ZCAN_CHANNEL_ERR_INFO& info)
+    {
+        const QMutexLocker locker{&_mutex};
+
+        ZCAN_CHANNEL_ERR_INFO read_info{};
+        ::memset(&read_info, 0, sizeof(read_info));
+        const auto result{counters.call(ZlgCanBackend::ReadChannelErrInfoFunction, [&]() {
+            return dll->ZCAN_ReadChannelErrInfo(channel_handle, &read_info);
+        })};
+        if(STATUS_OK != result)
+        {
+            return false;
+        }
+        counters.error(read_info.error_code);
+
+        // error bits accumulate, the captured registers are the latest ones
+        for(auto& pending: _pending)
+        {
+            pending.error_code |= read_info.error_code;
+            if(ZCAN_ERROR_CAN_PASSIVE & read_info.error_code)
+            {
+                ::memcpy(pending.passive_ErrData, read_info.passive_ErrData, sizeof(pending.passive_ErrData));
+            }
+            if(ZCAN_ERROR_CAN_LOSE & read_info.error_code)
+            {
+                pending.arLost_ErrData = read_info.arLost_ErrData;
+            }
+        }
+        info = _pending[reader];
+        ::memset(&_pending[reader], 0, sizeof(ZCAN_CHANNEL_ERR_INFO));
+        return true;
+    }
+
+    void ChannelErrors::reset()
+    {
+        const QMutexLocker locker{&_mutex};
+
+        for(auto& pending: _pending)
+        {
+            ::memset(&pending, 0, sizeof(ZCAN_CHANNEL_ERR_INFO));
+        }
+    }
+
+    IPropertyManager::IPropertyManager(DEVICE_HANDLE handle)
+    {
+        if(handle)
+        {
+            _iproperty = Loader::instance()->GetIProperty(handle);
+        }
+    }
+
+    IPropertyManager::~IPropertyManager()
+    {
+        if(_iproperty)
+        {
+            Loader::instance()->ReleaseIProperty(_iproperty);
+        }
+    }
+
+    IPropertyManager::operator bool() const
+    {
+        return _iproperty;
+    }
+
+    IProperty* IPropertyManager::operator->()
+    {
+        return _iproperty;
+    }
+
 } //namespace zlg
 
 ZlgCanBackendPrivate::ZlgCanBackendPrivate(ZlgCanBackend* q): q_ptr(q)
 {
     dll = zlg::Loader::instance();
+    _clock.start();
 }
 
 ZlgCanBackendPrivate::~ZlgCanBackendPrivate()
@@ -282,67 +414,144 @@ bool ZlgCanBackendPrivate::open()
 
     if(!_device_handle && !_channel_handle && _device_type)
     {
-        const QMutexLocker locker{&_mutex};
+        const zlg::ChannelLocker control_locker{_control_mutex};
+        const zlg::ChannelLocker tx_locker{_tx_mutex};
+        const zlg::ChannelLocker rx_locker{_rx_mutex};
 
-        const auto& device{zlg::get_devices()[_device_type]};
-        _device_handle = dll->ZCAN_OpenDevice(_device_type, _device_index, 0);
-        if(_device_handle)
+        _device_handle = zlg::DeviceRegistry::instance()->acquire(_device_type, _device_index, _channel_index);
+        _device_tx_mutex = zlg::DeviceRegistry::instance()->transmit_mutex(_device_type, _device_index);
+        if(_device_handle && startChannel())
         {
-            setConfigurations(static_cast<int>(zlg::ConfigureOrder::BEFORE_INIT_CAN));
-            ZCAN_CHANNEL_INIT_CONFIG config{};
-            ::memset(&config, 0, sizeof(config));
-            config.can_type = device.fd ? 1 : 0;
-            if(config.can_type)
-            {
-                config.canfd.acc_code = 0;
-                config.canfd.acc_mask = 0xFFFFFFFF;
-                // config.canfd.filter = 1;
-                // config.canfd.mode = 0;
-            }
-            else
-            {
-                config.can.acc_code = 0;
-                config.can.acc_mask = 0xFFFFFFFF;
-                // config.can.filter = 1;
-                // config.can.mode = 0;
-            }
-            _channel_handle = dll->ZCAN_InitCAN(_device_handle, _channel_index, &config);
-            if(_channel_handle)
-            {
-                setConfigurations(static_cast<int>(zlg::ConfigureOrder::BEFORE_START_CAN));
-                if(STATUS_OK == dll->ZCAN_StartCAN(_channel_handle))
-                {
-                    setConfigurations(static_cast<int>(zlg::ConfigureOrder::AFTER_START_CAN));
-                    _read_timer.start();
-                    return true;
-                }
-            }
+            return true;
         }
 
+        auto& error_string{systemErrorString()};
         if(_device_handle)
         {
-            dll->ZCAN_CloseDevice(_device_handle);
+            if(_channel_handle)
+            {
+                dll->ZCAN_ResetCAN(_channel_handle);
+            }
+            zlg::DeviceRegistry::instance()->release(_device_type, _device_index, _channel_index);
             _device_handle = INVALID_DEVICE_HANDLE;
             _channel_handle = INVALID_CHANNEL_HANDLE;
         }
-        auto& error_string{systemErrorString()};
+        _device_tx_mutex = nullptr;
         q->setError(error_string, QCanBusDevice::CanBusError::ConnectionError);
     }
     return _channel_handle;
 }
 
+// initializes and starts the channel on the acquired device, with all three channel mutexes held
+bool ZlgCanBackendPrivate::startChannel()
+{
+    const auto& device{zlg::get_device(_device_type)};
+    _channel_errors.reset();
+    zlg::IPropertyManager iproperty{_configuration_plan.iproperty ? _device_handle : INVALID_DEVICE_HANDLE};
+    if(!setConfigurations(static_cast<int>(zlg::ConfigureOrder::BEFORE_INIT_CAN), iproperty))
+    {
+        return false;
+    }
+    ZCAN_CHANNEL_INIT_CONFIG config{};
+    ::memset(&config, 0, sizeof(config));
+    config.can_type = device.fd ? 1 : 0;
+    UINT acc_code{0};
+    UINT acc_mask{0xFFFFFFFF};
+    const auto raw_filter{device.configuration(QCanBusDevice::RawFilterKey)};
+    const auto single_filter{raw_filter && zlg::ConfigureFunction::ZCAN_INITCAN == raw_filter->function && _filter.acceptance(acc_code, acc_mask)};
+    if(config.can_type)
+    {
+        config.canfd.acc_code = acc_code;
+        config.canfd.acc_mask = acc_mask;
+        config.canfd.filter = single_filter ? 1 : 0;
+        // config.canfd.mode = 0;
+    }
+    else
+    {
+        config.can.acc_code = acc_code;
+        config.can.acc_mask = acc_mask;
+        config.can.filter = single_filter ? 1 : 0;
+        // config.can.mode = 0;
+    }
+    _channel_handle = dll->ZCAN_InitCAN(_device_handle, _channel_index, &config);
+    if(!_channel_handle)
+    {
+        return false;
+    }
+    if(!setConfigurations(static_cast<int>(zlg::ConfigureOrder::BEFORE_START_CAN), iproperty) || STATUS_OK != dll->ZCAN_StartCAN(_channel_handle))
+    {
+        return false;
+    }
+    if(!setConfigurations(static_cast<int>(zlg::ConfigureOrder::AFTER_START_CAN), iproperty))
+    {
+        return false;
+    }
+
+    // the receive mode is shared by all channels of the adapter, see DeviceRegistry
+    const auto merge_requested{device.merge_receive && _configurations.value(static_cast<QCanBusDevice::ConfigurationKey>(ZlgCanBackend::MergeReceiveKey)).toBool()};
+    _merge_receive = zlg::DeviceRegistry::instance()->merge_receive(_device_type, _device_index, merge_requested);
+
+    // echoed frames only come back through ZCAN_ReceiveData, so echoes need merged reception
+    _transmit_data = device.transmit_data && _configurations.value(static_cast<QCanBusDevice::ConfigurationKey>(ZlgCanBackend::TransmitDataKey)).toBool();
+    _tx_echo = _transmit_data && _merge_receive;
+    _latency_histogram.reset();
+    _tx_latency_histogram.reset();
+    startReceiving();
+    startTransmitting();
+    return true;
+}
+
+/*!
+ * Applies changed bitrates to an open channel. The device stays open, so other
+ * channels of the adapter keep running; only this channel is reset and goes
+ * through ZCAN_InitCAN and ZCAN_StartCAN again with the new plan. Frames still
+ * queued and cyclic frames are dropped as on a reconnect.
+ */
+bool ZlgCanBackendPrivate::restartChannel()
+{
+    Q_Q(ZlgCanBackend);
+
+    clearCyclicFrames();
+    stopReceiving();
+    stopTransmitting();
+
+    const zlg::ChannelLocker control_locker{_control_mutex};
+    const zlg::ChannelLocker tx_locker{_tx_mutex};
+    const zlg::ChannelLocker rx_locker{_rx_mutex};
+
+    if(STATUS_OK == dll->ZCAN_ResetCAN(_channel_handle))
+    {
+        _channel_handle = INVALID_CHANNEL_HANDLE;
+        if(startChannel())
+        {
+            return true;
+        }
+    }
+    q->setError(systemErrorString(), QCanBusDevice::CanBusError::ConfigurationError);
+    return false;
+}
+
 void ZlgCanBackendPrivate::close()
 {
-    _read_timer.stop();
-    _write_timer.stop();
+    clearCyclicFrames();
+    stopReceiving();
+    stopTransmitting();
 
     if(_device_handle)
     {
-        const QMutexLocker channel_locker{&_mutex};
+        const zlg::ChannelLocker control_locker{_control_mutex};
+        const zlg::ChannelLocker tx_locker{_tx_mutex};
+        const zlg::ChannelLocker rx_locker{_rx_mutex};
 
-        dll->ZCAN_CloseDevice(_device_handle);
+        // other channels of the adapter may still be open, so the channel is stopped on its own
+        if(_channel_handle)
+        {
+            dll->ZCAN_ResetCAN(_channel_handle);
+        }
+        zlg::DeviceRegistry::instance()->release(_device_type, _device_index, _channel_index);
         _device_handle = INVALID_DEVICE_HANDLE;
         _channel_handle = INVALID_CHANNEL_HANDLE;
+        _device_tx_mutex = nullptr;
     }
 }
 
@@ -369,13 +578,17 @@ void ZlgCanBackendPrivate::setInterfaceName(const QString& interfaceName)
         }
     }
     _device_type = zlg::get_device_type(device_name);
-    const auto& device{zlg::get_devices()[_device_type]};
+    const auto& device{zlg::get_device(_device_type)};
     _fd_enabled = _device_type ? device.fd : false;
+    planConfigurations();
 }
 
 bool ZlgCanBackendPrivate::setConfigurationParameter(int key, const QVariant& value)
 {
+    Q_Q(ZlgCanBackend);
+
     auto configuration_key{static_cast<QCanBusDevice::ConfigurationKey>(key)};
+    const auto bitrate_changed{(QCanBusDevice::BitRateKey == configuration_key || QCanBusDevice::DataBitRateKey == configuration_key) && value != _configurations.value(configuration_key)};
     if(QCanBusDevice::ConfigurationKey::CanFdKey == configuration_key)
     {
         _fd_enabled = _fd_enabled && value.isValid() && value.toBool();
@@ -384,24 +597,99 @@ bool ZlgCanBackendPrivate::setConfigurationParameter(int key, const QVariant& va
     {
         _configurations[configuration_key] = value;
     }
+
+    if(QCanBusDevice::ErrorFilterKey == configuration_key)
+    {
+        // without the key every error class is passed on and ZCAN_CHANNEL_ERR_INFO is only read for the counters
+        _poll_errors = value.isValid();
+        _error_filter = _poll_errors ? value.value<QCanBusFrame::FrameErrors>() : QCanBusFrame::FrameErrors{QCanBusFrame::AnyError};
+    }
+    else if(QCanBusDevice::RawFilterKey == configuration_key)
+    {
+        _filter.set(value.value<QList<QCanBusDevice::Filter>>());
+    }
+    planConfigurations();
+
+    const auto& device{zlg::get_device(_device_type)};
+    if(QCanBusDevice::RawFilterKey == configuration_key)
+    {
+        const auto raw_filter{device.configuration(QCanBusDevice::RawFilterKey)};
+        if(_channel_handle && raw_filter)
+        {
+            if(zlg::ConfigureFunction::ZCAN_SETVALUE == raw_filter->function)
+            {
+                const zlg::ChannelLocker locker{_control_mutex};
+                if(!setFilterRanges())
+                {
+                    qCWarning(QT_CANBUS_PLUGINS_ZLGCAN, "Cannot update the hardware filter, frames are filtered in software only.");
+                }
+            }
+            else
+            {
+                qCInfo(QT_CANBUS_PLUGINS_ZLGCAN, "The hardware filter is updated when the device is opened again, frames are filtered in software until then.");
+            }
+        }
+    }
+    else if(bitrate_changed && _channel_handle && device.configuration(configuration_key))
+    {
+        if(!restartChannel())
+        {
+            qCWarning(QT_CANBUS_PLUGINS_ZLGCAN, "Cannot restart the channel with the new bitrate, closing it.");
+            q->close();
+        }
+    }
     return true;
 }
 
+bool ZlgCanBackendPrivate::writeFrame(const QCanBusFrame& frame)
+{
+    Q_Q(ZlgCanBackend);
+
+    if(!_transmitter)
+    {
+        q->enqueueOutgoingFrame(frame);
+        if(!_write_timer.isActive())
+        {
+            _write_timer.start();
+        }
+        return true;
+    }
+
+    // the transmitter converts without checking, so frames it cannot send are refused here
+    if(Q_UNLIKELY(frame.hasFlexibleDataRateFormat() && !_fd_enabled))
+    {
+        q->setError(QString{"Cannot send CAN FD frame format as CAN FD is not enabled."}, QCanBusDevice::WriteError);
+        return false;
+    }
+    const auto payload_size{frame.payload().size()};
+    if(Q_UNLIKELY(payload_size > (frame.hasFlexibleDataRateFormat() || (_fd_enabled && !_transmit_data) ? CANFD_MAX_DLEN : CAN_MAX_DLEN)))
+    {
+        q->setError(QString{"Cannot write frame with payload size %1."}.arg(payload_size), QCanBusDevice::WriteError);
+        return false;
+    }
+
+    // a full queue is back-pressure, not an error
+    return _transmit_queue.push(frame, _transmit_timeout);
+}
+
 void ZlgCanBackendPrivate::startWrite()
 {
     Q_Q(ZlgCanBackend);
 
     if(_channel_handle && q->hasOutgoingFrames())
     {
+        ZLGCAN_TRACE_SCOPE(trace, "startWrite");
         ZCAN_Transmit_Data data[64]{};
         ZCAN_TransmitFD_Data fd_data[64]{};
+        ZCANDataObj data_obj[64]{};
 
-        auto write_frame{[&]() {
+        auto write_data{[&]() {
             auto len{0U};
-            constexpr auto data_size{sizeof(data) / sizeof(data[0])};
-            while(q->hasOutgoingFrames() && len < data_size)
+            constexpr auto data_obj_size{sizeof(data_obj) / sizeof(data_obj[0])};
+            const auto limit{_tx_echo ? qMin(data_obj_size, echoRoom()) : data_obj_size};
+            while(q->hasOutgoingFrames() && len < limit)
             {
-                const auto frame{q->dequeueOutgoingFrame()};
+                const QCanBusFrame frame{q->dequeueOutgoingFrame()};
                 if(Q_UNLIKELY(!frame.isValid()))
                 {
                     QString error_string{"Invalid frame."};
@@ -409,15 +697,15 @@ void ZlgCanBackendPrivate::startWrite()
                     // q->setError(error_string, QCanBusDevice::WriteError);
                     continue;
                 }
-                if(Q_UNLIKELY(frame.hasFlexibleDataRateFormat()))
+                if(Q_UNLIKELY(frame.hasFlexibleDataRateFormat() && !_fd_enabled))
                 {
                     QString error_string{"Cannot send CAN FD frame format as CAN FD is not enabled."};
                     qCWarning(QT_CANBUS_PLUGINS_ZLGCAN(), error_string.toLatin1());
                     q->setError(error_string, QCanBusDevice::WriteError);
                     continue;
                 }
-                const auto payload{frame.payload()};
-                if(Q_UNLIKELY(payload.size() > sizeof(ZCAN_Transmit_Data::frame.data) / sizeof(ZCAN_Transmit_Data::frame.data[0])))
+                const QByteArray payload{frame.payload()};
+                if(Q_UNLIKELY(payload.size() > (frame.hasFlexibleDataRateFormat() ? CANFD_MAX_DLEN : CAN_MAX_DLEN)))
                 {
                     QString error_string{"Cannot write frame with payload size %1."};
                     qCWarning(QT_CANBUS_PLUGINS_ZLGCAN(), error_string.arg(payload.size()).toLatin1());
@@ -425,18 +713,82 @@ void ZlgCanBackendPrivate::startWrite()
                     continue;
                 }
 
-                ::memset(&data[len], 0, sizeof(ZCAN_Transmit_Data));
-                data[len].frame.can_id = MAKE_CAN_ID(frame.frameId(), frame.hasExtendedFrameFormat(), frame.frameType() == QCanBusFrame::RemoteRequestFrame, frame.frameType() == QCanBusFrame::ErrorFrame);
-                data[len].frame.can_dlc = payload.size();
-                ::memcpy_s(data[len].frame.data, sizeof(ZCAN_Transmit_Data::frame.data), payload, payload.size());
+                zlg::to_transmit_data(frame, _channel_index, _tx_echo, data_obj[len]);
+                if(_tx_echo)
+                {
+                    zlg::set_echo_tag(data_obj[len], _echo_sequence);
+                }
+                ++len;
+            }
+
+            auto result{0U};
+            {
+                const zlg::ChannelLocker locker{_tx_mutex};
+                const zlg::ChannelLocker device_locker{*_device_tx_mutex};
+                ZLGCAN_TRACE_SCOPE(call_trace, "ZCAN_TransmitData");
+                result = _counters.call(ZlgCanBackend::TransmitDataFunction, [&]() {
+                    return dll->ZCAN_TransmitData(_device_handle, data_obj, len);
+                });
+                ZLGCAN_TRACE_VALUE(call_trace, result);
+            }
+            _counters.transmitted(data_obj, result);
+
+            if(_tx_echo && result)
+            {
+                zlg::PendingEcho echoes[64]{};
+                const auto now{_clock.nsecsElapsed() / 1000};
+                for(auto i{0U}; i < result; ++i)
+                {
+                    echoes[i] = {data_obj[i].data.zcanCANFDData.frame.can_id, zlg::echo_tag(data_obj[i]), now};
+                }
+                _pending_echoes.push(echoes, result);
+            }
+            return result;
+        }};
+
+        auto write_frame{[&]() {
+            auto len{0U};
+            constexpr auto data_size{sizeof(data) / sizeof(data[0])};
+            while(q->hasOutgoingFrames() && len < data_size)
+            {
+                const auto frame{q->dequeueOutgoingFrame()};
+                if(Q_UNLIKELY(!frame.isValid()))
+                {
+                    QString error_string{"Invalid frame."};
+                    qCWarning(QT_CANBUS_PLUGINS_ZLGCAN(), error_string.toLatin1());
+                    // q->setError(error_string, QCanBusDevice::WriteError);
+                    continue;
+                }
+                if(Q_UNLIKELY(frame.hasFlexibleDataRateFormat()))
+                {
+                    QString error_string{"Cannot send CAN FD frame format as CAN FD is not enabled."};
+                    qCWarning(QT_CANBUS_PLUGINS_ZLGCAN(), error_string.toLatin1());
+                    q->setError(error_string, QCanBusDevice::WriteError);
+                    continue;
+                }
+                const auto payload{frame.payload()};
+                if(Q_UNLIKELY(payload.size() > sizeof(ZCAN_Transmit_Data::frame.data) / sizeof(ZCAN_Transmit_Data::frame.data[0])))
+                {
+                    QString error_string{"Cannot write frame with payload size %1."};
+                    qCWarning(QT_CANBUS_PLUGINS_ZLGCAN(), error_string.arg(payload.size()).toLatin1());
+                    // q->setError(error_string, QCanBusDevice::WriteError);
+                    continue;
+                }
+
+                zlg::to_transmit_data(frame, data[len]);
                 ++len;
             }
 
             auto result{0U};
             {
-                const QMutexLocker locker{&_mutex};
-                result = dll->ZCAN_Transmit(_channel_handle, data, len);
+                const zlg::ChannelLocker locker{_tx_mutex};
+                ZLGCAN_TRACE_SCOPE(call_trace, "ZCAN_Transmit");
+                result = _counters.call(ZlgCanBackend::TransmitFunction, [&]() {
+                    return dll->ZCAN_Transmit(_channel_handle, data, len);
+                });
+                ZLGCAN_TRACE_VALUE(call_trace, result);
             }
+            _counters.transmitted(data, result);
             return result;
         }};
 
@@ -462,168 +814,1066 @@ void ZlgCanBackendPrivate::startWrite()
                     continue;
                 }
 
-                ::memset(&fd_data[len], 0, sizeof(ZCAN_TransmitFD_Data));
-                fd_data[len].frame.can_id = MAKE_CAN_ID(frame.frameId(), frame.hasExtendedFrameFormat(), frame.frameType() == QCanBusFrame::RemoteRequestFrame, frame.frameType() == QCanBusFrame::ErrorFrame);
-                fd_data[len].frame.flags |= frame.hasBitrateSwitch() ? CANFD_BRS : 0;
-                fd_data[len].frame.len = payload.size();
-                ::memcpy_s(fd_data[len].frame.data, sizeof(ZCAN_TransmitFD_Data::frame.data), payload, payload.size());
+                zlg::to_transmit_data(frame, fd_data[len]);
                 ++len;
             }
 
             auto result{0U};
             {
-                const QMutexLocker locker{&_mutex};
-                result = dll->ZCAN_TransmitFD(_channel_handle, fd_data, len);
+                const zlg::ChannelLocker locker{_tx_mutex};
+                ZLGCAN_TRACE_SCOPE(call_trace, "ZCAN_TransmitFD");
+                result = _counters.call(ZlgCanBackend::TransmitFDFunction, [&]() {
+                    return dll->ZCAN_TransmitFD(_channel_handle, fd_data, len);
+                });
+                ZLGCAN_TRACE_VALUE(call_trace, result);
             }
+            _counters.transmitted(fd_data, result);
             return result;
         }};
 
-        auto count{0U};
-        while(q->hasOutgoingFrames())
+        auto count{0U};
+        while(q->hasOutgoingFrames())
+        {
+            // frames sent with an echo request wait in the queue until earlier echoes free their entries,
+            // the timer idles meanwhile and resumeWrite() restarts it
+            if(_transmit_data && _tx_echo && !echoRoom())
+            {
+                _write_timer.stop();
+                break;
+            }
+            auto result = _transmit_data ? write_data() : _fd_enabled ? write_frame_fd() : write_frame();
+            if(result > 0)
+            {
+                count += result;
+            }
+            else
+            {
+                auto& error_string{systemErrorString()};
+                qCWarning(QT_CANBUS_PLUGINS_ZLGCAN(), error_string.toLatin1());
+                q->setError(error_string, QCanBusDevice::CanBusError::WriteError);
+            }
+        }
+        ZLGCAN_TRACE_VALUE(trace, count);
+        // with tx echo, framesWritten is emitted once the device echoes the frames from the bus
+        if(count && !_tx_echo)
+        {
+            emit q->framesWritten(count);
+        }
+    }
+    else
+    {
+        _write_timer.stop();
+    }
+}
+
+void ZlgCanBackendPrivate::startRead()
+{
+    if(_channel_handle)
+    {
+        ZLGCAN_TRACE_SCOPE(trace, "startRead");
+        ZCAN_Receive_Data data[64]{};
+        ZCAN_ReceiveFD_Data fd_data[64]{};
+        const auto now{_clock.nsecsElapsed() / 1000};
+
+        auto receive_frame{[&](unsigned int size) {
+            constexpr auto data_size{sizeof(data) / sizeof(data[0])};
+            size = size > data_size ? data_size : size;
+            ::memset(&data, 0, sizeof(data[0]) * size);
+            auto result{0U};
+            {
+                const zlg::ChannelLocker locker{_rx_mutex};
+                ZLGCAN_TRACE_SCOPE(call_trace, "ZCAN_Receive");
+                result = _counters.call(ZlgCanBackend::ReceiveFunction, [&]() {
+                    return dll->ZCAN_Receive(_channel_handle, data, size, 0);
+                });
+                ZLGCAN_TRACE_VALUE(call_trace, result);
+            }
+            _counters.receive_batch(result);
+            auto received{std::size_t{0}};
+            {
+                ZLGCAN_TRACE_SCOPE(convert_trace, "convert");
+                ZLGCAN_TRACE_VALUE(convert_trace, result);
+                if(_reordering)
+                {
+                    _reorder.append(data, result, now);
+                }
+                else
+                {
+                    received = receive(data, result);
+                }
+            }
+            return received;
+        }};
+
+        auto receive_frame_fd{[&](unsigned int size) {
+            constexpr auto fd_data_size{sizeof(fd_data) / sizeof(fd_data[0])};
+            size = size > fd_data_size ? fd_data_size : size;
+            ::memset(&fd_data, 0, sizeof(fd_data[0]) * size);
+            auto result{0U};
+            {
+                const zlg::ChannelLocker locker{_rx_mutex};
+                ZLGCAN_TRACE_SCOPE(call_trace, "ZCAN_ReceiveFD");
+                result = _counters.call(ZlgCanBackend::ReceiveFDFunction, [&]() {
+                    return dll->ZCAN_ReceiveFD(_channel_handle, fd_data, size, 0);
+                });
+                ZLGCAN_TRACE_VALUE(call_trace, result);
+            }
+            _counters.receive_batch(result);
+            auto received{std::size_t{0}};
+            {
+                ZLGCAN_TRACE_SCOPE(convert_trace, "convert");
+                ZLGCAN_TRACE_VALUE(convert_trace, result);
+                if(_reordering)
+                {
+                    _fd_reorder.append(fd_data, result, now);
+                }
+                else
+                {
+                    received = receive(fd_data, result);
+                }
+            }
+            return received;
+        }};
+
+        auto size{0U};
+        auto backlog{0U};
+        auto receive_num{[&](BYTE type) {
+            return _counters.call(ZlgCanBackend::GetReceiveNumFunction, [&]() {
+                return dll->ZCAN_GetReceiveNum(_channel_handle, type);
+            });
+        }};
+        while((size = receive_num(0)))
+        {
+            backlog = qMax(backlog, size);
+            if(receive_frame(size) >= 256)
+            {
+                flushReceived();
+            }
+        }
+        while(_fd_enabled && (size = receive_num(1)))
+        {
+            backlog = qMax(backlog, size);
+            if(receive_frame_fd(size) >= 256)
+            {
+                flushReceived();
+            }
+        }
+        if(_reordering)
+        {
+            releaseOrdered(now, false);
+        }
+        pollChannelErrors(now);
+        flushReceived();
+        ZLGCAN_TRACE_VALUE(trace, backlog);
+
+        if(_adaptive_poll)
+        {
+            adaptPollInterval(backlog);
+        }
+    }
+    else
+    {
+        _read_timer.stop();
+    }
+}
+
+void ZlgCanBackendPrivate::adaptPollInterval(unsigned int backlog)
+{
+    // a full batch waiting means the bus outruns the timer, an empty queue means it can afford to wait longer
+    auto interval{_read_timer.interval()};
+    if(!backlog)
+    {
+        interval = qMin(qMax(interval * 2, _poll_interval_min), _poll_interval_max);
+    }
+    else if(backlog >= 64)
+    {
+        interval = _poll_interval_min;
+    }
+    else
+    {
+        interval = qMax(interval / 2, _poll_interval_min);
+    }
+    if(interval != _read_timer.interval())
+    {
+        _read_timer.setInterval(interval);
+    }
+}
+
+void ZlgCanBackendPrivate::startTransmitting()
+{
+    Q_Q(ZlgCanBackend);
+
+    _pending_echoes.reset(4096);
+    if(_tx_echo)
+    {
+        _echo_timer.start(static_cast<int>(echo_timeout / 4));
+    }
+
+    const auto transmit_mode{_configurations.value(static_cast<QCanBusDevice::ConfigurationKey>(ZlgCanBackend::TransmitModeKey)).toInt()};
+    if(ZlgCanBackend::ThreadTransmitMode == transmit_mode)
+    {
+        const auto queue_capacity_key{static_cast<QCanBusDevice::ConfigurationKey>(ZlgCanBackend::TransmitQueueCapacityKey)};
+        _transmit_queue.reset(_configurations.contains(queue_capacity_key) ? _configurations[queue_capacity_key].toInt() : 1024);
+        _transmit_timeout = _configurations.value(static_cast<QCanBusDevice::ConfigurationKey>(ZlgCanBackend::TransmitTimeoutKey)).toInt();
+
+        ZlgCanTransmitter::Context context{};
+        context.device_handle = _device_handle;
+        context.channel_handle = _channel_handle;
+        context.channel_index = _channel_index;
+        context.fd_enabled = _fd_enabled;
+        context.transmit_data = _transmit_data;
+        context.tx_echo = _tx_echo;
+        context.tx_mutex = &_tx_mutex;
+        context.device_tx_mutex = _device_tx_mutex;
+        context.control_mutex = &_control_mutex;
+        context.channel_errors = &_channel_errors;
+        context.queue = &_transmit_queue;
+        context.pending_echoes = &_pending_echoes;
+        context.echo_sequence = &_echo_sequence;
+        context.clock = &_clock;
+        context.counters = &_counters;
+        _transmitter = new ZlgCanTransmitter(dll, context);
+        QObject::connect(_transmitter, &ZlgCanTransmitter::framesSent, q, [this](qint64 count) {
+            Q_Q(ZlgCanBackend);
+
+            if(!_tx_echo)
+            {
+                emit q->framesWritten(count);
+            }
+        }, Qt::QueuedConnection);
+        QObject::connect(_transmitter, &ZlgCanTransmitter::transmitFailed, q, [this](unsigned int error_code, qint64 dropped) {
+            Q_Q(ZlgCanBackend);
+
+            qCWarning(QT_CANBUS_PLUGINS_ZLGCAN, "Dropped %lld frames after repeated transmit failures (error 0x%x).", dropped, error_code);
+            q->setError(zlg::error_string(error_code), QCanBusDevice::CanBusError::WriteError);
+        }, Qt::QueuedConnection);
+        _transmitter->start();
+    }
+    else if(q->hasOutgoingFrames())
+    {
+        _write_timer.start();
+    }
+}
+
+void ZlgCanBackendPrivate::stopTransmitting()
+{
+    _echo_timer.stop();
+    _write_timer.stop();
+    _schedule_timer.stop();
+    _schedule.clear();
+
+    if(_transmitter)
+    {
+        _transmitter->stop();
+        delete _transmitter;
+        _transmitter = nullptr;
+    }
+}
+
+bool ZlgCanBackendPrivate::scheduleFrames(const QVector<ZlgCanBackend::ScheduledFrame>& frames)
+{
+    Q_Q(ZlgCanBackend);
+
+    if(!zlg::get_device(_device_type).delay_send)
+    {
+        q->setError(QString{"Device does not support delayed send."}, QCanBusDevice::WriteError);
+        return false;
+    }
+    if(_schedule.active())
+    {
+        q->setError(QString{"Another schedule is still playing."}, QCanBusDevice::WriteError);
+        return false;
+    }
+    // the schedule is refilled from this thread, the transmitter records its echoes from its own
+    if(_transmitter && _tx_echo)
+    {
+        q->setError(QString{"Cannot schedule frames while the transmit thread waits for tx echoes."}, QCanBusDevice::WriteError);
+        return false;
+    }
+    for(const auto& scheduled_frame: frames)
+    {
+        const auto& frame{scheduled_frame.frame};
+        if(Q_UNLIKELY(!frame.isValid() || (frame.hasFlexibleDataRateFormat() && !_fd_enabled)))
+        {
+            q->setError(QString{"Cannot schedule frame %1."}.arg(frame.frameId(), 0, 16), QCanBusDevice::WriteError);
+            return false;
+        }
+        if(Q_UNLIKELY(frame.payload().size() > (frame.hasFlexibleDataRateFormat() || (_fd_enabled && !_transmit_data) ? CANFD_MAX_DLEN : CAN_MAX_DLEN)))
+        {
+            q->setError(QString{"Cannot write frame with payload size %1."}.arg(frame.payload().size()), QCanBusDevice::WriteError);
+            return false;
+        }
+    }
+
+    const auto lead_time_key{static_cast<QCanBusDevice::ConfigurationKey>(ZlgCanBackend::ScheduleLeadTimeKey)};
+    _schedule_lead = _configurations.contains(lead_time_key) ? _configurations[lead_time_key].toLongLong() : 50000;
+    _schedule.reset(frames);
+    refillSchedule();
+    if(_schedule.active())
+    {
+        // a quarter of the lead time keeps the device queue topped up even with coarse timers
+        _schedule_timer.start(static_cast<int>(qMax<qint64>(_schedule_lead / 4000, 1)));
+    }
+    return true;
+}
+
+void ZlgCanBackendPrivate::refillSchedule()
+{
+    Q_Q(ZlgCanBackend);
+
+    if(!_channel_handle || !_schedule.active())
+    {
+        _schedule_timer.stop();
+        return;
+    }
+
+    ZCAN_Transmit_Data data[64]{};
+    ZCAN_TransmitFD_Data fd_data[64]{};
+    ZCANDataObj data_obj[64]{};
+    constexpr auto data_size{sizeof(data) / sizeof(data[0])};
+
+    const auto now{_clock.nsecsElapsed() / 1000};
+    if(_schedule.start() < 0)
+    {
+        _schedule.start(now);
+    }
+    const auto position{now - _schedule.start() + _schedule.time(0)};
+
+    // the device plays its queue back on its own, the host only keeps it filled up to the lead time
+    const auto cursor{_schedule.cursor()};
+    const auto limit{_tx_echo ? qMin(data_size, echoRoom()) : data_size};
+    auto len{std::size_t{0}};
+    while(len < limit && cursor + len < _schedule.size() && _schedule.time(cursor + len) <= position + _schedule_lead)
+    {
+        const auto index{cursor + len};
+        if(_transmit_data)
+        {
+            zlg::to_transmit_data(_schedule.frame(index), _channel_index, _tx_echo, data_obj[len]);
+            zlg::set_delay(data_obj[len], _schedule.gap(index));
+            if(_tx_echo)
+            {
+                zlg::set_echo_tag(data_obj[len], _echo_sequence);
+            }
+        }
+        else if(_fd_enabled)
+        {
+            zlg::to_transmit_data(_schedule.frame(index), fd_data[len]);
+            zlg::set_delay(fd_data[len], _schedule.gap(index));
+        }
+        else
+        {
+            zlg::to_transmit_data(_schedule.frame(index), data[len]);
+            zlg::set_delay(data[len], _schedule.gap(index));
+        }
+        ++len;
+    }
+    if(!len)
+    {
+        return;
+    }
+
+    auto result{0U};
+    {
+        const zlg::ChannelLocker locker{_tx_mutex};
+        if(_transmit_data)
+        {
+            const zlg::ChannelLocker device_locker{*_device_tx_mutex};
+            result = _counters.call(ZlgCanBackend::TransmitDataFunction, [&]() {
+                return dll->ZCAN_TransmitData(_device_handle, data_obj, static_cast<UINT>(len));
+            });
+            _counters.transmitted(data_obj, result);
+        }
+        else if(_fd_enabled)
+        {
+            result = _counters.call(ZlgCanBackend::TransmitFDFunction, [&]() {
+                return dll->ZCAN_TransmitFD(_channel_handle, fd_data, static_cast<UINT>(len));
+            });
+            _counters.transmitted(fd_data, result);
+        }
+        else
+        {
+            result = _counters.call(ZlgCanBackend::TransmitFunction, [&]() {
+                return dll->ZCAN_Transmit(_channel_handle, data, static_cast<UINT>(len));
+            });
+            _counters.transmitted(data, result);
+        }
+    }
+
+    zlg::PendingEcho echoes[64]{};
+    for(auto i{0U}; i < result; ++i)
+    {
+        // a frame handed over after its send time found the device queue empty
+        const auto lateness{position - _schedule.time(cursor + i)};
+        if(lateness > 0)
+        {
+            _schedule.record_underrun();
+        }
+        if(_tx_echo)
+        {
+            echoes[i] = {data_obj[i].data.zcanCANFDData.frame.can_id, zlg::echo_tag(data_obj[i]), now, _schedule.time(cursor + i)};
+        }
+        else
+        {
+            _schedule.record_drift(lateness > 0 ? lateness : 0);
+        }
+    }
+    if(_tx_echo && result)
+    {
+        _pending_echoes.push(echoes, result);
+    }
+    _schedule.advance(result);
+
+    if(result && !_tx_echo)
+    {
+        emit q->framesWritten(result);
+    }
+    if(!_schedule.active())
+    {
+        _schedule_timer.stop();
+    }
+}
+
+void ZlgCanBackendPrivate::cancelSchedule()
+{
+    _schedule_timer.stop();
+    if(_schedule.start() >= 0 && _channel_handle)
+    {
+        const zlg::ChannelLocker locker{_control_mutex};
+        dll->ZCAN_SetValue(_device_handle, QString("%1/clear_delay_send_queue").arg(_channel_index).toLatin1(), "0");
+    }
+    _schedule.clear();
+}
+
+int ZlgCanBackendPrivate::addCyclicFrame(const QCanBusFrame& frame, int interval, int start_delay)
+{
+    Q_Q(ZlgCanBackend);
+
+    if(Q_UNLIKELY(frame.hasFlexibleDataRateFormat() && !_fd_enabled))
+    {
+        q->setError(QString{"Cannot send CAN FD frame format as CAN FD is not enabled."}, QCanBusDevice::WriteError);
+        return -1;
+    }
+    const auto payload_size{frame.payload().size()};
+    if(Q_UNLIKELY(payload_size > (frame.hasFlexibleDataRateFormat() ? CANFD_MAX_DLEN : CAN_MAX_DLEN)))
+    {
+        q->setError(QString{"Cannot add cyclic frame with payload size %1."}.arg(payload_size), QCanBusDevice::WriteError);
+        return -1;
+    }
+
+    zlg::CyclicFrame cyclic_frame{};
+    cyclic_frame.frame = frame;
+    cyclic_frame.interval = interval;
+    cyclic_frame.start_delay = start_delay;
+
+    // take the lowest free auto_send object; without one the frame is sent from the host
+    const auto& device{zlg::get_device(_device_type)};
+    for(auto index{0}; index < static_cast<int>(device.auto_send) && cyclic_frame.index < 0; ++index)
+    {
+        auto used{false};
+        for(const auto& other: _cyclic_frames)
+        {
+            used = used || other.index == index;
+        }
+        cyclic_frame.index = used ? -1 : index;
+    }
+
+    if(cyclic_frame.index >= 0 && !setAutoSend(cyclic_frame, true))
+    {
+        qCWarning(QT_CANBUS_PLUGINS_ZLGCAN, "Cannot set auto_send object %d, sending from the host instead.", cyclic_frame.index);
+        cyclic_frame.index = -1;
+    }
+
+    const auto id{_next_cyclic_id++};
+    if(cyclic_frame.index < 0)
+    {
+        if(!_cyclic_sender)
+        {
+            ZlgCanCyclicSender::Context context{};
+            context.channel_handle = _channel_handle;
+            context.tx_mutex = &_tx_mutex;
+            context.clock = &_clock;
+            context.counters = &_counters;
+            _cyclic_sender = new ZlgCanCyclicSender(dll, context);
+            _cyclic_sender->start(QThread::TimeCriticalPriority);
+        }
+        _cyclic_sender->insert(id, frame, interval, start_delay);
+    }
+    _cyclic_frames.insert(id, cyclic_frame);
+    return id;
+}
+
+bool ZlgCanBackendPrivate::updateCyclicFrame(int id, const QByteArray& payload)
+{
+    Q_Q(ZlgCanBackend);
+
+    if(!_cyclic_frames.contains(id))
+    {
+        return false;
+    }
+
+    auto& cyclic_frame{_cyclic_frames[id]};
+    if(Q_UNLIKELY(payload.size() > (cyclic_frame.frame.hasFlexibleDataRateFormat() ? CANFD_MAX_DLEN : CAN_MAX_DLEN)))
+    {
+        q->setError(QString{"Cannot update cyclic frame with payload size %1."}.arg(payload.size()), QCanBusDevice::WriteError);
+        return false;
+    }
+    cyclic_frame.frame.setPayload(payload);
+    if(cyclic_frame.index >= 0)
+    {
+        return setAutoSend(cyclic_frame, true);
+    }
+    return _cyclic_sender && _cyclic_sender->update(id, payload);
+}
+
+bool ZlgCanBackendPrivate::removeCyclicFrame(int id)
+{
+    if(!_cyclic_frames.contains(id))
+    {
+        return false;
+    }
+
+    const auto cyclic_frame{_cyclic_frames.take(id)};
+    if(cyclic_frame.index >= 0)
+    {
+        return setAutoSend(cyclic_frame, false);
+    }
+    return _cyclic_sender && _cyclic_sender->remove(id);
+}
+
+void ZlgCanBackendPrivate::clearCyclicFrames()
+{
+    if(_cyclic_sender)
+    {
+        _cyclic_sender->stop();
+        delete _cyclic_sender;
+        _cyclic_sender = nullptr;
+    }
+
+    auto has_auto_send{false};
+    for(const auto& cyclic_frame: _cyclic_frames)
+    {
+        has_auto_send = has_auto_send || cyclic_frame.index >= 0;
+    }
+    if(has_auto_send && _channel_handle)
+    {
+        const zlg::ChannelLocker locker{_control_mutex};
+        dll->ZCAN_SetValue(_device_handle, QString("%1/clear_auto_send").arg(_channel_index).toLatin1(), "0");
+    }
+    _cyclic_frames.clear();
+}
+
+bool ZlgCanBackendPrivate::setAutoSend(const zlg::CyclicFrame& cyclic_frame, bool enable)
+{
+    const zlg::ChannelLocker locker{_control_mutex};
+
+    auto result{false};
+    if(cyclic_frame.frame.hasFlexibleDataRateFormat())
+    {
+        ZCANFD_AUTO_TRANSMIT_OBJ auto_transmit{};
+        ::memset(&auto_transmit, 0, sizeof(auto_transmit));
+        auto_transmit.enable = enable ? 1 : 0;
+        auto_transmit.index = cyclic_frame.index;
+        auto_transmit.interval = cyclic_frame.interval;
+        zlg::to_transmit_data(cyclic_frame.frame, auto_transmit.obj);
+        result = STATUS_OK == dll->ZCAN_SetValue(_device_handle, QString("%1/auto_send_canfd").arg(_channel_index).toLatin1(), &auto_transmit);
+    }
+    else
+    {
+        ZCAN_AUTO_TRANSMIT_OBJ auto_transmit{};
+        ::memset(&auto_transmit, 0, sizeof(auto_transmit));
+        auto_transmit.enable = enable ? 1 : 0;
+        auto_transmit.index = cyclic_frame.index;
+        auto_transmit.interval = cyclic_frame.interval;
+        zlg::to_transmit_data(cyclic_frame.frame, auto_transmit.obj);
+        result = STATUS_OK == dll->ZCAN_SetValue(_device_handle, QString("%1/auto_send").arg(_channel_index).toLatin1(), &auto_transmit);
+    }
+
+    if(result && enable && cyclic_frame.start_delay > 0)
+    {
+        ZCAN_AUTO_TRANSMIT_OBJ_PARAM param{};
+        param.index = cyclic_frame.index;
+        param.type = 1;
+        param.value = cyclic_frame.start_delay;
+        result = STATUS_OK == dll->ZCAN_SetValue(_device_handle, QString("%1/auto_send_param").arg(_channel_index).toLatin1(), &param);
+    }
+    return result && STATUS_OK == dll->ZCAN_SetValue(_device_handle, QString("%1/apply_auto_send").arg(_channel_index).toLatin1(), "0");
+}
+
+void ZlgCanBackendPrivate::startReceiving()
+{
+    Q_Q(ZlgCanBackend);
+
+    _raw_frames_enabled = _configurations.value(static_cast<QCanBusDevice::ConfigurationKey>(ZlgCanBackend::RawFrameModeKey)).toBool();
+
+    const auto payload_pool_size_key{static_cast<QCanBusDevice::ConfigurationKey>(ZlgCanBackend::PayloadPoolSizeKey)};
+    _payload_pool.reset(_configurations.contains(payload_pool_size_key) ? _configurations[payload_pool_size_key].toInt() : 1024);
+
+    // only the split receive path delivers CAN and CAN FD records out of order
+    const auto reorder_window_key{static_cast<QCanBusDevice::ConfigurationKey>(ZlgCanBackend::ReorderWindowKey)};
+    _reorder_window = _configurations.value(reorder_window_key, -1).toLongLong();
+    _reordering = _fd_enabled && !_merge_receive && _reorder_window >= 0;
+    _reorder.clear();
+    _fd_reorder.clear();
+
+    _receive_own = _configurations.value(QCanBusDevice::ReceiveOwnKey).toBool();
+    _frames_echoed = 0;
+
+    const auto wait_time_key{static_cast<QCanBusDevice::ConfigurationKey>(ZlgCanBackend::ReceiveWaitTimeKey)};
+    auto wait_time{_configurations.contains(wait_time_key) ? _configurations[wait_time_key].toInt() : 10};
+    if(wait_time < 1)
+    {
+        qCWarning(QT_CANBUS_PLUGINS_ZLGCAN, "Receive wait time %d ms would busy-spin the receive thread, using 1 ms.", wait_time);
+        wait_time = 1;
+    }
+
+    const auto ring_capacity_key{static_cast<QCanBusDevice::ConfigurationKey>(ZlgCanBackend::ReceiveRingCapacityKey)};
+    const auto ring_capacity{_configurations.contains(ring_capacity_key) ? _configurations[ring_capacity_key].toUInt() : 4096U};
+    _raw_capacity = static_cast<qsizetype>(qMax(ring_capacity, 1U));
+
+    const auto receive_mode_key{static_cast<QCanBusDevice::ConfigurationKey>(ZlgCanBackend::ReceiveModeKey)};
+    const auto receive_mode{_configurations.value(receive_mode_key).toInt()};
+    if(_merge_receive)
+    {
+        // merged records of all channels come from one ZCAN_ReceiveData reader per adapter, whatever the receive mode
+        if(_configurations.contains(receive_mode_key) && ZlgCanBackend::ThreadReceiveMode != receive_mode)
+        {
+            qCWarning(QT_CANBUS_PLUGINS_ZLGCAN, "Receive mode %d is ignored with merged reception, receiving on the adapter's thread.", receive_mode);
+        }
+        _data_ring.reset(ring_capacity);
+        _subscriber.ring = &_data_ring;
+        _subscriber.notified.store(false, std::memory_order_relaxed);
+        _subscriber.counters = &_counters;
+        _subscriber.notify = [q, this]() {
+            QMetaObject::invokeMethod(q, [this]() {
+                drainReceiveRings();
+            }, Qt::QueuedConnection);
+        };
+        zlg::DeviceRegistry::instance()->subscribe(_device_type, _device_index, _channel_index, &_subscriber, wait_time);
+        _subscribed = true;
+    }
+    else if(ZlgCanBackend::ThreadReceiveMode == receive_mode)
+    {
+        _ring.reset(ring_capacity);
+        _fd_ring.reset(_fd_enabled ? ring_capacity : 0);
+
+        ZlgCanReceiver::Context context{};
+        context.channel_handle = _channel_handle;
+        context.fd_enabled = _fd_enabled;
+        context.wait_time = wait_time;
+        context.ring = &_ring;
+        context.fd_ring = &_fd_ring;
+        context.counters = &_counters;
+        _receiver = new ZlgCanReceiver(dll, context);
+        QObject::connect(_receiver, &ZlgCanReceiver::framesAvailable, q, [this]() {
+            drainReceiveRings();
+        }, Qt::QueuedConnection);
+        _receiver->start();
+    }
+    else
+    {
+        // the adaptive timer starts at the short end and backs off while the bus stays idle, in ms
+        _adaptive_poll = ZlgCanBackend::AdaptiveTimerReceiveMode == receive_mode;
+        _poll_interval_min = qMax(_configurations.value(static_cast<QCanBusDevice::ConfigurationKey>(ZlgCanBackend::PollIntervalMinKey), 1).toInt(), 1);
+        _poll_interval_max = qMax(_configurations.value(static_cast<QCanBusDevice::ConfigurationKey>(ZlgCanBackend::PollIntervalMaxKey), 100).toInt(), _poll_interval_min);
+        _read_timer.setTimerType(_adaptive_poll ? Qt::PreciseTimer : Qt::CoarseTimer);
+        _read_timer.setInterval(_adaptive_poll ? _poll_interval_min : 0);
+        _read_timer.start();
+    }
+}
+
+void ZlgCanBackendPrivate::stopReceiving()
+{
+    _read_timer.stop();
+
+    if(_subscribed)
+    {
+        zlg::DeviceRegistry::instance()->unsubscribe(_device_type, _device_index, _channel_index);
+        drainReceiveRings();
+        _subscribed = false;
+    }
+
+    if(_receiver)
+    {
+        _receiver->stop();
+        drainReceiveRings();
+        delete _receiver;
+        _receiver = nullptr;
+    }
+
+    _reorder_timer.stop();
+    if(_reordering)
+    {
+        releaseOrdered(_clock.nsecsElapsed() / 1000, true);
+        flushReceived();
+    }
+}
+
+void ZlgCanBackendPrivate::drainReceiveRings()
+{
+    if(_receiver)
+    {
+        _receiver->acknowledge();
+    }
+    else if(_subscribed)
+    {
+        _subscriber.notified.store(false, std::memory_order_release);
+    }
+    else
+    {
+        return;
+    }
+    ZLGCAN_TRACE_SCOPE(trace, "drainReceiveRings");
+
+    ZCAN_Receive_Data data[64]{};
+    ZCAN_ReceiveFD_Data fd_data[64]{};
+    ZCANDataObj data_obj[64]{};
+    constexpr auto data_size{sizeof(data) / sizeof(data[0])};
+    constexpr auto fd_data_size{sizeof(fd_data) / sizeof(fd_data[0])};
+    constexpr auto data_obj_size{sizeof(data_obj) / sizeof(data_obj[0])};
+
+    const auto now{_clock.nsecsElapsed() / 1000};
+    auto size{std::size_t{0}};
+    while((size = _data_ring.pop(data_obj, data_obj_size)))
+    {
+        receive(data_obj, size);
+    }
+    while((size = _ring.pop(data, data_size)))
+    {
+        if(_reordering)
         {
-            auto result = _fd_enabled ? write_frame_fd() : write_frame();
-            if(result > 0)
-            {
-                count += result;
-            }
-            else
-            {
-                auto& error_string{systemErrorString()};
-                qCWarning(QT_CANBUS_PLUGINS_ZLGCAN(), error_string.toLatin1());
-                q->setError(error_string, QCanBusDevice::CanBusError::WriteError);
-            }
+            _reorder.append(data, size, now);
         }
-        if(count)
+        else
         {
-            emit q->framesWritten(count);
+            receive(data, size);
         }
     }
-    else
+    while((size = _fd_ring.pop(fd_data, fd_data_size)))
     {
-        _write_timer.stop();
+        if(_reordering)
+        {
+            _fd_reorder.append(fd_data, size, now);
+        }
+        else
+        {
+            receive(fd_data, size);
+        }
+    }
+    if(_reordering)
+    {
+        releaseOrdered(now, false);
     }
+    pollChannelErrors(now);
+    flushReceived();
 }
 
-void ZlgCanBackendPrivate::startRead()
+void ZlgCanBackendPrivate::pollChannelErrors(qint64 now)
 {
-    Q_Q(ZlgCanBackend);
+    // merged reception delivers error records of its own; the others are read for the overflow counter even unfiltered
+    if(_merge_receive || !_channel_handle || now - _error_poll_time < zlg::error::poll_interval)
+    {
+        return;
+    }
+    _error_poll_time = now;
 
-    if(_channel_handle)
+    ZCAN_CHANNEL_ERR_INFO info{};
+    auto result{false};
+    {
+        const zlg::ChannelLocker locker{_control_mutex};
+        result = _channel_errors.read(zlg::ChannelErrors::POLL, dll, _channel_handle, _counters, info);
+    }
+    if(!_poll_errors || !result || !info.error_code)
     {
-        QCanBusFrame frame{};
-        QVector<QCanBusFrame> frames{};
-        frames.reserve(256);
+        return;
+    }
 
-        ZCAN_Receive_Data data[64]{};
-        ZCAN_ReceiveFD_Data fd_data[64]{};
+    // the vendor does not timestamp ZCAN_CHANNEL_ERR_INFO, so these frames carry none
+    const auto error_frame{zlg::error::from(info)};
+    if(!int(error_frame.error_class & _error_filter))
+    {
+        return;
+    }
+    if(_raw_frames_enabled)
+    {
+        _raw_batch.append(zlg::to_raw_frame(error_frame, 0));
+    }
+    else
+    {
+        zlg::to_frame(error_frame, 0, _frame);
+        _received_frames.append(_frame);
+    }
+}
 
-        auto receive_frame{[&](unsigned int size) {
-            constexpr auto data_size{sizeof(data) / sizeof(data[0])};
-            size = size > data_size ? data_size : size;
-            ::memset(&data, 0, sizeof(data[0]) * size);
-            auto result{0U};
+void ZlgCanBackendPrivate::releaseOrdered(qint64 now, bool flush)
+{
+    // a record is released once the other queue holds a later one, or once it has waited out the reorder window
+    while(!_reorder.empty() || !_fd_reorder.empty())
+    {
+        const auto from_fd{_reorder.empty() || (!_fd_reorder.empty() && _fd_reorder.timestamp() < _reorder.timestamp())};
+        const auto size{from_fd ? _fd_reorder.size() : _reorder.size()};
+        auto count{std::size_t{0}};
+        if(from_fd ? _reorder.empty() : _fd_reorder.empty())
+        {
+            while(count < size && (flush || now - (from_fd ? _fd_reorder.arrival(count) : _reorder.arrival(count)) >= _reorder_window))
             {
-                const QMutexLocker locker{&_mutex};
-                result = dll->ZCAN_Receive(_channel_handle, data, size, 0);
+                ++count;
             }
-            for(unsigned int i = 0; i < result; ++i)
+        }
+        else
+        {
+            const auto limit{from_fd ? _reorder.timestamp() : _fd_reorder.timestamp()};
+            while(count < size && (from_fd ? _fd_reorder.timestamp(count) < limit : _reorder.timestamp(count) <= limit))
             {
-                frame.setFrameId(GET_ID(data[i].frame.can_id));
-                frame.setPayload(QByteArray(reinterpret_cast<char*>(data[i].frame.data), int(data[i].frame.can_dlc)));
-                frame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(data[i].timestamp));
-                frame.setExtendedFrameFormat(IS_EFF(data[i].frame.can_id));
-                if(IS_ERR(data[i].frame.can_id))
-                {
-                    frame.setFrameType(QCanBusFrame::ErrorFrame);
-                }
-                else if(IS_RTR(data[i].frame.can_id))
-                {
-                    frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
-                }
-                else
-                {
-                    frame.setFrameType(QCanBusFrame::DataFrame);
-                }
-                frames.append(frame);
+                ++count;
             }
-        }};
+        }
 
-        auto receive_frame_fd{[&](unsigned int size) {
-            constexpr auto fd_data_size{sizeof(fd_data) / sizeof(fd_data[0])};
-            size = size > fd_data_size ? fd_data_size : size;
-            ::memset(&fd_data, 0, sizeof(fd_data[0]) * size);
-            auto result{0U};
-            {
-                const QMutexLocker locker{&_mutex};
-                result = dll->ZCAN_ReceiveFD(_channel_handle, fd_data, size, 0);
-            }
-            for(auto i{0U}; i < result; ++i)
-            {
-                frame.setFrameId(GET_ID(fd_data[i].frame.can_id));
-                frame.setPayload(QByteArray(reinterpret_cast<char*>(fd_data[i].frame.data), int(fd_data[i].frame.len)));
-                frame.setFlexibleDataRateFormat(true);
-                frame.setBitrateSwitch(fd_data[i].frame.flags & CANFD_BRS);
-                frame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(fd_data[i].timestamp));
-                frame.setExtendedFrameFormat(IS_EFF(fd_data[i].frame.can_id));
-                if(IS_ERR(fd_data[i].frame.can_id))
-                {
-                    frame.setFrameType(QCanBusFrame::ErrorFrame);
-                }
-                else
-                {
-                    frame.setFrameType(QCanBusFrame::DataFrame);
-                }
-                frames.append(frame);
-            }
-        }};
+        if(!count)
+        {
+            break;
+        }
+        if((from_fd ? receive(_fd_reorder.data(), count) : receive(_reorder.data(), count)) >= 256)
+        {
+            flushReceived();
+        }
+        if(from_fd)
+        {
+            _fd_reorder.pop(count);
+        }
+        else
+        {
+            _reorder.pop(count);
+        }
+    }
 
-        auto size{0U};
-        while((size = dll->ZCAN_GetReceiveNum(_channel_handle, 0)))
+    if(_reorder.empty() && _fd_reorder.empty())
+    {
+        _reorder_timer.stop();
+    }
+    else if(!_reorder_timer.isActive())
+    {
+        const auto oldest{_reorder.empty() ? _fd_reorder.arrival() : _fd_reorder.empty() ? _reorder.arrival() : qMin(_reorder.arrival(), _fd_reorder.arrival())};
+        const auto remaining{oldest + _reorder_window - now};
+        _reorder_timer.start(static_cast<int>(qMax<qint64>(remaining + 999, 0) / 1000));
+    }
+}
+
+template<typename T>
+std::size_t ZlgCanBackendPrivate::receive(const T* data, std::size_t size)
+{
+    const auto now{_clock.nsecsElapsed() / 1000};
+    auto frames{quint64{0}};
+    auto bytes{quint64{0}};
+    if(_raw_frames_enabled)
+    {
+        for(auto i{std::size_t{0}}; i < size; ++i)
         {
-            receive_frame(size);
-            if(frames.size() >= 256)
+            if(zlg::accept(data[i], _channel_index) && !consumeEcho(data[i]) && zlg::error::pass(data[i], _error_filter) && _filter.accept(data[i]))
             {
-                q->enqueueReceivedFrames(frames);
-                frames.clear();
+                _latency_histogram.record(zlg::timestamp_of(data[i]), now);
+                const auto raw_frame{zlg::to_raw_frame(data[i])};
+                _raw_batch.append(raw_frame);
+                ++frames;
+                bytes += raw_frame.length;
             }
         }
-        while(_fd_enabled && (size = dll->ZCAN_GetReceiveNum(_channel_handle, 1)))
+        _counters.received(frames, bytes);
+        return _raw_batch.size();
+    }
+
+    _payload_pool.tick(now);
+    for(auto i{std::size_t{0}}; i < size; ++i)
+    {
+        if(!zlg::accept(data[i], _channel_index) || consumeEcho(data[i]) || !zlg::error::pass(data[i], _error_filter) || !_filter.accept(data[i]))
         {
-            receive_frame_fd(size);
-            if(frames.size() >= 256)
-            {
-                q->enqueueReceivedFrames(frames);
-                frames.clear();
-            }
+            continue;
         }
-        if(!frames.isEmpty())
+        _latency_histogram.record(zlg::timestamp_of(data[i]), now);
+        zlg::to_frame(data[i], _frame, _payload_pool);
+        _received_frames.append(_frame);
+        ++frames;
+        bytes += static_cast<quint64>(_frame.payload().size());
+    }
+    _counters.received(frames, bytes);
+    return _received_frames.size();
+}
+
+template<typename T>
+bool ZlgCanBackendPrivate::consumeEcho(const T&)
+{
+    return false;
+}
+
+bool ZlgCanBackendPrivate::consumeEcho(const ZCANDataObj& data)
+{
+    const auto& can_data{data.data.zcanCANFDData};
+    if(ZCAN_DT_ZCAN_CAN_CANFD_DATA != data.dataType || !can_data.flag.unionVal.txEchoed)
+    {
+        return false;
+    }
+
+    // the device echoes in transmit order; entries before the match belong to frames it never echoed,
+    // an echo matching none belongs to a frame already counted by expireEchoes()
+    zlg::PendingEcho echo{};
+    auto count{std::size_t{0}};
+    auto matched{false};
+    const auto tag{zlg::echo_tag(data)};
+    if(tag)
+    {
+        // tags wrap around, so entries are ordered by their distance to the echo's tag
+        while(!matched && _pending_echoes.peek(&echo, 1) && static_cast<qint32>(echo.tag - tag) <= 0)
         {
-            q->enqueueReceivedFrames(frames);
-            frames.clear();
+            matched = echo.tag == tag;
+            _pending_echoes.pop(&echo, 1);
+            ++count;
         }
     }
     else
     {
-        _read_timer.stop();
+        // an echo that came back without its tag is matched by id, within the oldest entries only
+        zlg::PendingEcho echoes[64]{};
+        const auto size{_pending_echoes.peek(echoes, sizeof(echoes) / sizeof(echoes[0]))};
+        while(!matched && count < size)
+        {
+            echo = echoes[count++];
+            matched = echo.can_id == can_data.frame.can_id;
+        }
+        count = matched ? _pending_echoes.pop(echoes, count) : 0;
+    }
+
+    if(matched)
+    {
+        // hardware echo time against host submit time, relative to the smallest offset seen
+        _tx_latency_histogram.record(static_cast<quint64>(echo.submitted), static_cast<qint64>(can_data.timeStamp));
+        if(echo.scheduled >= 0)
+        {
+            _schedule.record_echo(static_cast<qint64>(can_data.timeStamp) - echo.scheduled);
+        }
+    }
+    if(count)
+    {
+        _frames_echoed += static_cast<qint64>(count);
+        resumeWrite();
+    }
+    return !_receive_own;
+}
+
+std::size_t ZlgCanBackendPrivate::echoRoom() const
+{
+    return _pending_echoes.capacity() - _pending_echoes.size();
+}
+
+// a lost echo would hold framesWritten back for good, so its frame is counted once it is echo_timeout old
+void ZlgCanBackendPrivate::expireEchoes()
+{
+    Q_Q(ZlgCanBackend);
+
+    const auto now{_clock.nsecsElapsed() / 1000};
+    auto expired{qint64{0}};
+    zlg::PendingEcho echo{};
+    while(_pending_echoes.peek(&echo, 1) && now - echo.submitted >= echo_timeout * 1000)
+    {
+        _pending_echoes.pop(&echo, 1);
+        ++expired;
+    }
+    if(expired)
+    {
+        emit q->framesWritten(expired);
+        resumeWrite();
+    }
+}
+
+void ZlgCanBackendPrivate::resumeWrite()
+{
+    Q_Q(ZlgCanBackend);
+
+    if(!_transmitter && !_write_timer.isActive() && q->hasOutgoingFrames())
+    {
+        _write_timer.start();
     }
 }
 
+void ZlgCanBackendPrivate::flushReceived()
+{
+    Q_Q(ZlgCanBackend);
+
+    if(_frames_echoed)
+    {
+        emit q->framesWritten(_frames_echoed);
+        _frames_echoed = 0;
+    }
+
+    if(!_received_frames.isEmpty())
+    {
+        QElapsedTimer timer{};
+        timer.start();
+        q->enqueueReceivedFrames(_received_frames);
+        _counters.enqueued(timer.nsecsElapsed());
+        _received_frames.clear();
+    }
+
+    // raw frames nobody reads are capped like the receive rings, the newest ones are dropped
+    const auto room{qMax<qsizetype>(_raw_capacity - _raw_pending, 0)};
+    if(_raw_batch.size() > room)
+    {
+        _counters.raw_dropped(static_cast<quint64>(_raw_batch.size() - room));
+        _raw_batch.resize(room);
+    }
+    if(!_raw_batch.isEmpty())
+    {
+        _raw_pending += _raw_batch.size();
+        _raw_batches.append(std::move(_raw_batch));
+        _raw_batch = _raw_pool.isEmpty() ? QVector<ZlgCanBackend::RawFrame>{} : _raw_pool.takeLast();
+        emit q->rawFramesReceived();
+    }
+}
+
+qint64 ZlgCanBackendPrivate::readRawFrames(const std::function<void(std::span<const ZlgCanBackend::RawFrame>)>& visitor)
+{
+    auto count{qint64{0}};
+    for(auto& batch: _raw_batches)
+    {
+        visitor(std::span<const ZlgCanBackend::RawFrame>(batch.constData(), static_cast<std::size_t>(batch.size())));
+        count += batch.size();
+        batch.clear();
+        _raw_pool.append(std::move(batch));
+    }
+    _raw_batches.clear();
+    _raw_pending = 0;
+    return count;
+}
+
 void ZlgCanBackendPrivate::resetController()
 {
     Q_Q(ZlgCanBackend);
 
     if(_channel_handle)
     {
+        stopReceiving();
+        stopTransmitting();
+
         auto result{false};
         {
-            const QMutexLocker locker{&_mutex};
+            const zlg::ChannelLocker control_locker{_control_mutex};
+            const zlg::ChannelLocker tx_locker{_tx_mutex};
+            const zlg::ChannelLocker rx_locker{_rx_mutex};
             result = (STATUS_OK == dll->ZCAN_ResetCAN(_channel_handle)) && (STATUS_OK == dll->ZCAN_StartCAN(_channel_handle));
         }
 
         if(result)
         {
-            _read_timer.start();
-            _write_timer.start();
+            _latency_histogram.reset();
+            startReceiving();
+            startTransmitting();
+
+            // the controller reset discards the device's auto_send objects
+            for(const auto& cyclic_frame: _cyclic_frames)
+            {
+                if(cyclic_frame.index >= 0)
+                {
+                    setAutoSend(cyclic_frame, true);
+                }
+            }
         }
         else
         {
@@ -642,8 +1892,8 @@ QCanBusDevice::CanBusStatus ZlgCanBackendPrivate::busStatus()
         ZCAN_CHANNEL_ERR_INFO error_info{};
         auto result{false};
         {
-            const QMutexLocker locker{&_mutex};
-            result = STATUS_OK == dll->ZCAN_ReadChannelErrInfo(_channel_handle, &error_info);
+            const zlg::ChannelLocker locker{_control_mutex};
+            result = _channel_errors.read(zlg::ChannelErrors::STATUS, dll, _channel_handle, _counters, error_info);
         }
         if(result)
         {
@@ -674,171 +1924,145 @@ QCanBusDevice::CanBusStatus ZlgCanBackendPrivate::busStatus()
     return QCanBusDevice::CanBusStatus::Unknown;
 }
 
-bool ZlgCanBackendPrivate::setConfigurations(int order)
+void ZlgCanBackendPrivate::planConfigurations()
 {
-    Q_Q(ZlgCanBackend);
-    Q_UNUSED(q)
+    _configuration_plan = zlg::ConfigurationPlan{};
+    if(!_device_type)
+    {
+        return;
+    }
 
-    class IPropertyManager
+    const auto& device{zlg::get_device(_device_type)};
+    auto configurations{_configurations};
+    if(!_fd_enabled && device.fd && configurations.contains(QCanBusDevice::BitRateKey))
     {
-        Q_DISABLE_COPY(IPropertyManager)
+        configurations[QCanBusDevice::DataBitRateKey] = configurations[QCanBusDevice::BitRateKey];
+    }
 
-    public:
-        explicit IPropertyManager(void* handle)
+    for(auto iter{configurations.cbegin()}; iter != configurations.cend(); ++iter)
+    {
+        const auto configuration{device.configuration(iter.key())};
+        // ZCAN_InitCAN keys are part of ZCAN_CHANNEL_INIT_CONFIG, see startChannel()
+        if(!iter.value().isValid() || !configuration || zlg::ConfigureFunction::ZCAN_INITCAN == configuration->function)
         {
-            dll = zlg::Loader::instance();
-            _iproperty = dll->GetIProperty(handle);
+            continue;
         }
 
-        virtual ~IPropertyManager()
+        zlg::ConfigurationWrite write{iter.key(), configuration->function};
+        switch(static_cast<int>(iter.key()))
         {
-            if(_iproperty)
+            case QCanBusDevice::RawFilterKey:
             {
-                dll->ReleaseIProperty(_iproperty);
+                if(zlg::ConfigureFunction::ZCAN_SETVALUE != configuration->function)
+                {
+                    continue;
+                }
+                break;
             }
-        }
-
-        operator bool()
-        {
-            return _iproperty;
-        }
-
-        IProperty* operator->()
-        {
-            return _iproperty;
-        }
-
-    private:
-        IProperty* _iproperty{};
-        const zlg::Loader* dll{};
-    };
-
-    IPropertyManager iproperty_manager{_device_handle};
-
-    auto set_value{[&](const QByteArray& path, const QByteArray& value, zlg::ConfigureFunction method) -> bool {
-        if(!path.isEmpty() && !value.isEmpty())
-        {
-            if(zlg::ConfigureFunction::ZCAN_SETVALUE == method)
+            case QCanBusDevice::BitRateKey:
             {
-                return STATUS_OK == dll->ZCAN_SetValue(_device_handle, path, value);
+                const auto bitrate{iter.value().toUInt()};
+                const auto* key{device.fd ? "canfd_abit_baud_rate" : zlg::contains(device.bitrate, bitrate) ? "baud_rate" : "baud_rate_custom"};
+                write.path = QByteArray::number(_channel_index) + '/' + key;
+                write.value = QByteArray::number(bitrate);
+                break;
             }
-
-            else if(zlg::ConfigureFunction::IPROPERTY_SETVALUE == method)
+            case QCanBusDevice::DataBitRateKey:
             {
-                return iproperty_manager->SetValue(path, value);
+                const auto data_bitrate{iter.value().toUInt()};
+                if(!device.fd || !zlg::contains(device.data_field_bitrate, data_bitrate))
+                {
+                    continue;
+                }
+                write.path = QByteArray::number(_channel_index) + "/canfd_dbit_baud_rate";
+                write.value = QByteArray::number(data_bitrate);
+                break;
             }
-            return true;
+            // error classes are filtered on the host, see pollChannelErrors() and receive()
+            default: continue;
         }
-        return false;
-    }};
+        _configuration_plan.phases[static_cast<int>(configuration->order)].append(write);
+        _configuration_plan.iproperty = _configuration_plan.iproperty || zlg::ConfigureFunction::IPROPERTY_SETVALUE == configuration->function;
+    }
 
-    if(_device_handle && _device_type)
+    // filter_clear alone lets everything through, which is also what an unfiltered channel needs
+    auto& filter{_configuration_plan.filter};
+    auto append_filter{[&](const char* key, const QByteArray& value) {
+        filter.append({QCanBusDevice::RawFilterKey, zlg::ConfigureFunction::ZCAN_SETVALUE, QByteArray::number(_channel_index) + '/' + key, value});
+    }};
+    append_filter("filter_clear", "0");
+    const auto ranges{_filter.ranges(static_cast<int>(device.filters))};
+    for(const auto& range: ranges)
+    {
+        append_filter("filter_mode", range.extended ? "1" : "0");
+        append_filter("filter_start", QByteArray::number(range.start, 16).prepend("0x"));
+        append_filter("filter_end", QByteArray::number(range.end, 16).prepend("0x"));
+    }
+    if(!ranges.isEmpty())
     {
-        QByteArray path{};
-        QByteArray value{};
-        const auto& device{zlg::get_devices()[_device_type]};
-        const auto configure_order{static_cast<zlg::ConfigureOrder>(order)};
+        append_filter("filter_ack", "0");
+    }
+}
 
-        if(!_fd_enabled && device.fd && _configurations.contains(QCanBusDevice::BitRateKey))
-        {
-            _configurations[QCanBusDevice::DataBitRateKey] = _configurations[QCanBusDevice::BitRateKey];
-        }
+bool ZlgCanBackendPrivate::setConfigurations(int order, zlg::IPropertyManager& iproperty)
+{
+    if(!_device_handle || !_device_type)
+    {
+        return false;
+    }
 
-        for(auto iter{_configurations.cbegin()}; iter != _configurations.cend(); ++iter)
+    for(const auto& write: _configuration_plan.phases[order])
+    {
+        if(QCanBusDevice::RawFilterKey == write.key)
         {
-            if(!iter.value().isValid() || !device.configurations.contains(iter.key()))
-            {
-                continue;
-            }
-
-            auto& configuration{device.configurations[iter.key()]};
-            if(!configuration.configurable || configuration.order != configure_order)
+            if(!setFilterRanges())
             {
-                continue;
+                qCWarning(QT_CANBUS_PLUGINS_ZLGCAN, "Cannot set the hardware filter of channel %u.", _channel_index);
+                return false;
             }
-
-            path.clear();
-            value.clear();
-            switch(static_cast<int>(iter.key()))
+        }
+        else if(zlg::ConfigureFunction::ZCAN_SETVALUE == write.function)
+        {
+            // paths are per channel; the adapter keeps a value the channel already has, so it is not written again
+            if(!zlg::DeviceRegistry::instance()->set_value(_device_type, _device_index, write.path, write.value))
             {
-                case QCanBusDevice::RawFilterKey: break;
-                case QCanBusDevice::ErrorFilterKey: break;
-                case QCanBusDevice::LoopbackKey: break;
-                case QCanBusDevice::ReceiveOwnKey: break;
-                case QCanBusDevice::BitRateKey:
-                {
-                    auto bitrate{iter.value().toUInt()};
-                    QString str{QString("%1/baud_rate")};
-                    if(!device.bitrate.contains(bitrate))
-                    {
-                        str = QString("%1/baud_rate_custom");
-                    }
-                    if(device.fd)
-                    {
-                        str = QString("%1/canfd_abit_baud_rate");
-                    }
-                    path = str.arg(_channel_index).toLatin1();
-                    value = QByteArray::number(bitrate);
-                    break;
-                }
-                case QCanBusDevice::CanFdKey:
-                {
-                    _fd_enabled = device.fd && iter.value().toBool();
-                    break;
-                }
-                case QCanBusDevice::DataBitRateKey:
-                {
-                    auto data_bitrate{iter.value().toUInt()};
-                    if(device.fd && device.data_field_bitrate.contains(data_bitrate))
-                    {
-                        path = QString("%1/canfd_dbit_baud_rate").arg(_channel_index).toLatin1();
-                        value = QByteArray::number(data_bitrate);
-                    }
-                    break;
-                }
+                qCWarning(QT_CANBUS_PLUGINS_ZLGCAN, "Cannot set %s to %s.", write.path.constData(), write.value.constData());
+                return false;
             }
-            if(!path.isEmpty() && !value.isEmpty() && !set_value(path, value, configuration.function))
+        }
+        else if(zlg::ConfigureFunction::IPROPERTY_SETVALUE == write.function)
+        {
+            if(!iproperty || !iproperty->SetValue(write.path, write.value))
             {
+                qCWarning(QT_CANBUS_PLUGINS_ZLGCAN, "Cannot set %s to %s.", write.path.constData(), write.value.constData());
                 return false;
             }
         }
-        return true;
     }
-    return false;
+    return true;
 }
 
-const QString& ZlgCanBackendPrivate::systemErrorString(int* error_code)
+bool ZlgCanBackendPrivate::setFilterRanges()
 {
-    static QHash<unsigned int, QString> dict{
-        {                             0,                "Unknown error"},
-        {       ZCAN_ERROR_CAN_OVERFLOW, "CAN controller FIFO overflow"},
-        {       ZCAN_ERROR_CAN_ERRALARM,         "CAN controller alarm"},
-        {        ZCAN_ERROR_CAN_PASSIVE,       "CAN controller passive"},
-        {           ZCAN_ERROR_CAN_LOSE,          "CAN controller lose"},
-        {         ZCAN_ERROR_CAN_BUSERR,     "CAN controller bus error"},
-        {         ZCAN_ERROR_CAN_BUSOFF,       "CAN controller bus off"},
-        {ZCAN_ERROR_CAN_BUFFER_OVERFLOW,          "CAN buffer overflow"},
-        {       ZCAN_ERROR_DEVICEOPENED,                "Device opened"},
-        {         ZCAN_ERROR_DEVICEOPEN,            "Open device error"},
-        {      ZCAN_ERROR_DEVICENOTOPEN,    "The buffer cannot be read"},
-        {     ZCAN_ERROR_BUFFEROVERFLOW,              "Buffer overflow"},
-        {     ZCAN_ERROR_DEVICENOTEXIST,             "Device not exist"},
-        {      ZCAN_ERROR_LOADKERNELDLL,        "Load kernel dll error"},
-        {          ZCAN_ERROR_CMDFAILED,            "Run command error"},
-        {       ZCAN_ERROR_BUFFERCREATE,          "Create buffer error"},
-    };
+    for(const auto& write: _configuration_plan.filter)
+    {
+        if(STATUS_OK != dll->ZCAN_SetValue(_device_handle, write.path, write.value))
+        {
+            return false;
+        }
+    }
+    return true;
+}
 
+const QString& ZlgCanBackendPrivate::systemErrorString(int* error_code)
+{
     ZCAN_CHANNEL_ERR_INFO info{};
     ::memset(&info, 0, sizeof(info));
-    if(_channel_handle && STATUS_OK == dll->ZCAN_ReadChannelErrInfo(_channel_handle, &info) && error_code)
+    if(_channel_handle && _channel_errors.read(zlg::ChannelErrors::ERROR_STRING, dll, _channel_handle, _counters, info) && error_code)
     {
         *error_code = info.error_code;
     }
-    if(dict.contains(info.error_code))
-    {
-        return dict[info.error_code];
-    }
-    return dict[0];
+    return zlg::error_string(info.error_code);
 }
 
 QT_END_NAMESPACE
@@ -3,55 +3,136 @@
 
 #include "zlgcan/zlgcan.h"
 #include "zlgcanbackend.h"
-
-#include <windows.h>
-#undef SendMessage
-#undef ERROR
-
+#include "zlgcancounters_p.h"
+#include "zlgcandevices_p.h"
+#include "zlgcanfilter_p.h"
+#include "zlgcanlock_p.h"
+#include "zlgcanpool_p.h"
+#include "zlgcanqueue_p.h"
+#include "zlgcanreorder_p.h"
+#include "zlgcanring_p.h"
+#include "zlgcanschedule_p.h"
+#include "zlgcantrace_p.h"
+
+#include <QCanBusFrame>
+#include <QElapsedTimer>
 #include <QHash>
+#include <QLibrary>
 #include <QMutex>
-#include <QSet>
 #include <QThread>
 #include <QTimer>
 #include <QTimerEvent>
 #include <QVariant>
+#include <QVector>
 #include <zlgcan/zlgcan.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <span>
 
 QT_BEGIN_NAMESPACE
 
 namespace zlg
 {
-    enum class ConfigureFunction
+    struct CyclicFrame
     {
-        ZCAN_INITCAN,
-        ZCAN_SETVALUE,
-        IPROPERTY_SETVALUE,
+        QCanBusFrame frame{};
+        int interval{0};
+        int start_delay{0};
+        int index{-1};
     };
 
-    enum class ConfigureOrder
+    struct PendingEcho
     {
-        BEFORE_INIT_CAN,
-        BEFORE_START_CAN,
-        AFTER_START_CAN,
+        canid_t can_id{0};
+        quint32 tag{0};
+        qint64 submitted{0};
+        qint64 scheduled{-1};
     };
 
-    struct Configuration
+    struct ReceiveSubscriber
     {
-        QCanBusDevice::ConfigurationKey key{QCanBusDevice::UserKey};
-        bool configurable{false};
-        ConfigureFunction function{ConfigureFunction::ZCAN_SETVALUE};
-        ConfigureOrder order{ConfigureOrder::BEFORE_INIT_CAN};
+        SpscRing<ZCANDataObj>* ring{};
+        std::atomic_bool notified{false};
+        std::function<void()> notify{};
+        PerformanceCounters* counters{};
     };
 
-    struct Device
+    class LatencyHistogram
     {
-        QString name{};
-        unsigned int type{0};
-        bool fd{false};
-        unsigned int channels{0};
-        QHash<QCanBusDevice::ConfigurationKey, Configuration> configurations{};
-        QSet<unsigned int> bitrate{};
-        QSet<unsigned int> data_field_bitrate{};
+    public:
+        static constexpr int size{32};
+
+        void record(quint64 timestamp, qint64 now);
+        QVector<quint64> buckets() const;
+        void reset();
+
+    private:
+        quint64 _buckets[size]{};
+        qint64 _offset{std::numeric_limits<qint64>::max()};
+    };
+
+    void to_frame(const ZCAN_Receive_Data& data, QCanBusFrame& frame, PayloadPool& pool);
+    void to_frame(const ZCAN_ReceiveFD_Data& data, QCanBusFrame& frame, PayloadPool& pool);
+    void to_frame(const ZCANDataObj& data, QCanBusFrame& frame, PayloadPool& pool);
+    ZlgCanBackend::RawFrame to_raw_frame(const ZCAN_Receive_Data& data);
+    ZlgCanBackend::RawFrame to_raw_frame(const ZCAN_ReceiveFD_Data& data);
+    ZlgCanBackend::RawFrame to_raw_frame(const ZCANDataObj& data);
+    const QString& error_string(unsigned int error_code);
+    void to_transmit_data(const QCanBusFrame& frame, ZCAN_Transmit_Data& data);
+    void to_transmit_data(const QCanBusFrame& frame, ZCAN_TransmitFD_Data& data);
+    void to_transmit_data(const QCanBusFrame& frame, unsigned int channel, bool echo, ZCANDataObj& data);
+    // tx echoes hand extraData back as it was sent, so it carries a tag numbering them; 0 marks an untagged echo
+    void set_echo_tag(ZCANDataObj& data, quint32& sequence);
+    quint32 echo_tag(const ZCANDataObj& data);
+
+    class Loader;
+
+    /*!
+     * One entry point of the vendor library, resolved on its first call rather
+     * than when the Loader is created, so creating a backend or listing the
+     * interfaces does not load the library or look up functions it never uses.
+     * Calling an entry point the library lacks, or when it cannot be loaded,
+     * returns a zero result, which the ZLG API reads as STATUS_ERR or an invalid
+     * handle.
+     */
+    template<typename Function>
+    class Symbol;
+
+    template<typename Result, typename... Args>
+    class Symbol<Result (*)(Args...)>
+    {
+        Symbol(const Symbol&) = delete;
+        Symbol& operator=(const Symbol&) = delete;
+
+    public:
+        typedef Result (*Function)(Args...);
+
+        Symbol(const Loader* loader, const char* name): _loader(loader), _name(name) {}
+
+        Result operator()(Args... args) const
+        {
+            const auto function{get()};
+            if(Q_UNLIKELY(!function))
+            {
+                return Result();
+            }
+            return function(args...);
+        }
+
+        explicit operator bool() const
+        {
+            return get();
+        }
+
+    private:
+        Function get() const;
+
+        const Loader* _loader{};
+        const char* _name{};
+        mutable std::atomic<Function> _function{};
+        mutable std::atomic_bool _resolved{false};
     };
 
     class Loader
@@ -64,121 +145,213 @@ namespace zlg
     public:
         static const Loader* instance();
 
+        QFunctionPointer resolve(const char* name) const;
+
     private:
         explicit Loader();
         ~Loader();
 
     public:
         typedef DEVICE_HANDLE (*pf_ZCAN_OpenDevice)(UINT, UINT, UINT);
-        pf_ZCAN_OpenDevice ZCAN_OpenDevice{};
+        Symbol<pf_ZCAN_OpenDevice> ZCAN_OpenDevice{this, "ZCAN_OpenDevice"};
 
         typedef UINT (*pf_ZCAN_CloseDevice)(DEVICE_HANDLE);
-        pf_ZCAN_CloseDevice ZCAN_CloseDevice{};
+        Symbol<pf_ZCAN_CloseDevice> ZCAN_CloseDevice{this, "ZCAN_CloseDevice"};
 
         typedef UINT (*pf_ZCAN_GetDeviceInf)(DEVICE_HANDLE, ZCAN_DEVICE_INFO*);
-        pf_ZCAN_GetDeviceInf ZCAN_GetDeviceInf{};
+        Symbol<pf_ZCAN_GetDeviceInf> ZCAN_GetDeviceInf{this, "ZCAN_GetDeviceInf"};
 
         typedef UINT (*pf_ZCAN_IsDeviceOnLine)(DEVICE_HANDLE);
-        pf_ZCAN_IsDeviceOnLine ZCAN_IsDeviceOnLine{};
+        Symbol<pf_ZCAN_IsDeviceOnLine> ZCAN_IsDeviceOnLine{this, "ZCAN_IsDeviceOnLine"};
 
         typedef CHANNEL_HANDLE (*pf_ZCAN_InitCAN)(DEVICE_HANDLE, UINT, ZCAN_CHANNEL_INIT_CONFIG*);
-        pf_ZCAN_InitCAN ZCAN_InitCAN{};
+        Symbol<pf_ZCAN_InitCAN> ZCAN_InitCAN{this, "ZCAN_InitCAN"};
 
         typedef UINT (*pf_ZCAN_StartCAN)(CHANNEL_HANDLE);
-        pf_ZCAN_StartCAN ZCAN_StartCAN{};
+        Symbol<pf_ZCAN_StartCAN> ZCAN_StartCAN{this, "ZCAN_StartCAN"};
 
         typedef UINT (*pf_ZCAN_ResetCAN)(CHANNEL_HANDLE);
-        pf_ZCAN_ResetCAN ZCAN_ResetCAN{};
+        Symbol<pf_ZCAN_ResetCAN> ZCAN_ResetCAN{this, "ZCAN_ResetCAN"};
 
         typedef UINT (*pf_ZCAN_ClearBuffer)(CHANNEL_HANDLE);
-        pf_ZCAN_ClearBuffer ZCAN_ClearBuffer{};
+        Symbol<pf_ZCAN_ClearBuffer> ZCAN_ClearBuffer{this, "ZCAN_ClearBuffer"};
 
         typedef UINT (*pf_ZCAN_ReadChannelErrInfo)(CHANNEL_HANDLE, ZCAN_CHANNEL_ERR_INFO*);
-        pf_ZCAN_ReadChannelErrInfo ZCAN_ReadChannelErrInfo{};
+        Symbol<pf_ZCAN_ReadChannelErrInfo> ZCAN_ReadChannelErrInfo{this, "ZCAN_ReadChannelErrInfo"};
 
         typedef UINT (*pf_ZCAN_ReadChannelStatus)(CHANNEL_HANDLE, ZCAN_CHANNEL_STATUS*);
-        pf_ZCAN_ReadChannelStatus ZCAN_ReadChannelStatus{};
+        Symbol<pf_ZCAN_ReadChannelStatus> ZCAN_ReadChannelStatus{this, "ZCAN_ReadChannelStatus"};
 
         typedef UINT (*pf_ZCAN_GetReceiveNum)(CHANNEL_HANDLE, BYTE);
-        pf_ZCAN_GetReceiveNum ZCAN_GetReceiveNum{};
+        Symbol<pf_ZCAN_GetReceiveNum> ZCAN_GetReceiveNum{this, "ZCAN_GetReceiveNum"};
 
         typedef UINT (*pf_ZCAN_Transmit)(CHANNEL_HANDLE, ZCAN_Transmit_Data*, UINT);
-        pf_ZCAN_Transmit ZCAN_Transmit{};
+        Symbol<pf_ZCAN_Transmit> ZCAN_Transmit{this, "ZCAN_Transmit"};
 
         typedef UINT (*pf_ZCAN_Receive)(CHANNEL_HANDLE, ZCAN_Receive_Data*, UINT, int);
-        pf_ZCAN_Receive ZCAN_Receive{};
+        Symbol<pf_ZCAN_Receive> ZCAN_Receive{this, "ZCAN_Receive"};
 
         typedef UINT (*pf_ZCAN_TransmitFD)(CHANNEL_HANDLE, ZCAN_TransmitFD_Data*, UINT);
-        pf_ZCAN_TransmitFD ZCAN_TransmitFD{};
+        Symbol<pf_ZCAN_TransmitFD> ZCAN_TransmitFD{this, "ZCAN_TransmitFD"};
 
         typedef UINT (*pf_ZCAN_ReceiveFD)(CHANNEL_HANDLE, ZCAN_ReceiveFD_Data*, UINT, int);
-        pf_ZCAN_ReceiveFD ZCAN_ReceiveFD{};
+        Symbol<pf_ZCAN_ReceiveFD> ZCAN_ReceiveFD{this, "ZCAN_ReceiveFD"};
 
         typedef UINT (*pf_ZCAN_TransmitData)(DEVICE_HANDLE, ZCANDataObj*, UINT);
-        pf_ZCAN_TransmitData ZCAN_TransmitData{};
+        Symbol<pf_ZCAN_TransmitData> ZCAN_TransmitData{this, "ZCAN_TransmitData"};
 
         typedef UINT (*pf_ZCAN_ReceiveData)(DEVICE_HANDLE, ZCANDataObj*, UINT, int);
-        pf_ZCAN_ReceiveData ZCAN_ReceiveData{};
+        Symbol<pf_ZCAN_ReceiveData> ZCAN_ReceiveData{this, "ZCAN_ReceiveData"};
 
         typedef UINT (*pf_ZCAN_SetValue)(DEVICE_HANDLE, const char*, const void*);
-        pf_ZCAN_SetValue ZCAN_SetValue{};
+        Symbol<pf_ZCAN_SetValue> ZCAN_SetValue{this, "ZCAN_SetValue"};
 
         typedef const void* (*pf_ZCAN_GetValue)(DEVICE_HANDLE, const char*);
-        pf_ZCAN_GetValue ZCAN_GetValue{};
+        Symbol<pf_ZCAN_GetValue> ZCAN_GetValue{this, "ZCAN_GetValue"};
 
         typedef IProperty* (*pf_GetIProperty)(DEVICE_HANDLE);
-        pf_GetIProperty GetIProperty{};
+        Symbol<pf_GetIProperty> GetIProperty{this, "GetIProperty"};
 
         typedef UINT (*pf_ReleaseIProperty)(IProperty*);
-        pf_ReleaseIProperty ReleaseIProperty{};
+        Symbol<pf_ReleaseIProperty> ReleaseIProperty{this, "ReleaseIProperty"};
 
         typedef void (*pf_ZCLOUD_SetServerInfo)(const char*, unsigned short, const char*, unsigned short);
-        pf_ZCLOUD_SetServerInfo ZCLOUD_SetServerInfo{};
+        Symbol<pf_ZCLOUD_SetServerInfo> ZCLOUD_SetServerInfo{this, "ZCLOUD_SetServerInfo"};
 
         typedef UINT (*pf_ZCLOUD_ConnectServer)(const char*, const char*);
-        pf_ZCLOUD_ConnectServer ZCLOUD_ConnectServer{};
+        Symbol<pf_ZCLOUD_ConnectServer> ZCLOUD_ConnectServer{this, "ZCLOUD_ConnectServer"};
 
         typedef bool (*pf_ZCLOUD_IsConnected)();
-        pf_ZCLOUD_IsConnected ZCLOUD_IsConnected{};
+        Symbol<pf_ZCLOUD_IsConnected> ZCLOUD_IsConnected{this, "ZCLOUD_IsConnected"};
 
         typedef UINT (*pf_ZCLOUD_DisconnectServer)();
-        pf_ZCLOUD_DisconnectServer ZCLOUD_DisconnectServer{};
+        Symbol<pf_ZCLOUD_DisconnectServer> ZCLOUD_DisconnectServer{this, "ZCLOUD_DisconnectServer"};
 
         typedef const ZCLOUD_USER_DATA* (*pf_ZCLOUD_GetUserData)(int);
-        pf_ZCLOUD_GetUserData ZCLOUD_GetUserData{};
+        Symbol<pf_ZCLOUD_GetUserData> ZCLOUD_GetUserData{this, "ZCLOUD_GetUserData"};
 
         typedef UINT (*pf_ZCLOUD_ReceiveGPS)(DEVICE_HANDLE, ZCLOUD_GPS_FRAME*, UINT, int);
-        pf_ZCLOUD_ReceiveGPS ZCLOUD_ReceiveGPS{};
+        Symbol<pf_ZCLOUD_ReceiveGPS> ZCLOUD_ReceiveGPS{this, "ZCLOUD_ReceiveGPS"};
 
         typedef CHANNEL_HANDLE (*pf_ZCAN_InitLIN)(DEVICE_HANDLE, UINT, PZCAN_LIN_INIT_CONFIG);
-        pf_ZCAN_InitLIN ZCAN_InitLIN{};
+        Symbol<pf_ZCAN_InitLIN> ZCAN_InitLIN{this, "ZCAN_InitLIN"};
 
         typedef UINT (*pf_ZCAN_StartLIN)(CHANNEL_HANDLE);
-        pf_ZCAN_StartLIN ZCAN_StartLIN{};
+        Symbol<pf_ZCAN_StartLIN> ZCAN_StartLIN{this, "ZCAN_StartLIN"};
 
         typedef UINT (*pf_ZCAN_ResetLIN)(CHANNEL_HANDLE);
-        pf_ZCAN_ResetLIN ZCAN_ResetLIN{};
+        Symbol<pf_ZCAN_ResetLIN> ZCAN_ResetLIN{this, "ZCAN_ResetLIN"};
 
         typedef UINT (*pf_ZCAN_TransmitLIN)(CHANNEL_HANDLE, PZCAN_LIN_MSG, UINT);
-        pf_ZCAN_TransmitLIN ZCAN_TransmitLIN{};
+        Symbol<pf_ZCAN_TransmitLIN> ZCAN_TransmitLIN{this, "ZCAN_TransmitLIN"};
 
         typedef UINT (*pf_ZCAN_GetLINReceiveNum)(CHANNEL_HANDLE);
-        pf_ZCAN_GetLINReceiveNum ZCAN_GetLINReceiveNum{};
+        Symbol<pf_ZCAN_GetLINReceiveNum> ZCAN_GetLINReceiveNum{this, "ZCAN_GetLINReceiveNum"};
 
         typedef UINT (*pf_ZCAN_ReceiveLIN)(CHANNEL_HANDLE, PZCAN_LIN_MSG, UINT, int);
-        pf_ZCAN_ReceiveLIN ZCAN_ReceiveLIN{};
+        Symbol<pf_ZCAN_ReceiveLIN> ZCAN_ReceiveLIN{this, "ZCAN_ReceiveLIN"};
 
         typedef UINT (*pf_ZCAN_SetLINSlaveMsg)(CHANNEL_HANDLE, PZCAN_LIN_MSG, UINT);
-        pf_ZCAN_SetLINSlaveMsg ZCAN_SetLINSlaveMsg{};
+        Symbol<pf_ZCAN_SetLINSlaveMsg> ZCAN_SetLINSlaveMsg{this, "ZCAN_SetLINSlaveMsg"};
 
         typedef UINT (*pf_ZCAN_ClearLINSlaveMsg)(CHANNEL_HANDLE, BYTE*, UINT);
-        pf_ZCAN_ClearLINSlaveMsg ZCAN_ClearLINSlaveMsg{};
+        Symbol<pf_ZCAN_ClearLINSlaveMsg> ZCAN_ClearLINSlaveMsg{this, "ZCAN_ClearLINSlaveMsg"};
 
     private:
-        HINSTANCE _handle{NULL};
+        mutable QMutex _mutex{};
+        mutable QLibrary _library{};
+        mutable bool _load_tried{false};
+    };
+
+    template<typename Result, typename... Args>
+    typename Symbol<Result (*)(Args...)>::Function Symbol<Result (*)(Args...)>::get() const
+    {
+        auto function{_function.load(std::memory_order_acquire)};
+        if(Q_LIKELY(function))
+        {
+            return function;
+        }
+        if(_resolved.load(std::memory_order_acquire))
+        {
+            return _function.load(std::memory_order_relaxed);
+        }
+        // racing first calls resolve the same address, storing it twice is harmless
+        function = reinterpret_cast<Function>(_loader->resolve(_name));
+        _function.store(function, std::memory_order_release);
+        _resolved.store(true, std::memory_order_release);
+        return function;
+    }
+
+    /*!
+     * ZCAN_ReadChannelErrInfo clears what it returns, so a channel's errors are
+     * read through one ChannelErrors and kept for every reader until that reader
+     * reads again: pollChannelErrors(), busStatus(), the transmitter and
+     * systemErrorString() each see all errors raised since their own last read,
+     * whichever of them read the channel. It may be used from any thread.
+     */
+    class ChannelErrors
+    {
+    public:
+        enum Reader
+        {
+            POLL,
+            STATUS,
+            TRANSMIT,
+            ERROR_STRING,
+            READERS,
+        };
+
+        bool read(Reader reader, const Loader* dll, CHANNEL_HANDLE channel_handle, PerformanceCounters& counters, ZCAN_CHANNEL_ERR_INFO& info);
+        void reset();
+
+    private:
+        QMutex _mutex{};
+        std::array<ZCAN_CHANNEL_ERR_INFO, READERS> _pending{};
+    };
+
+    // one vendor write, the path and value formatted when the plan is made
+    struct ConfigurationWrite
+    {
+        QCanBusDevice::ConfigurationKey key{QCanBusDevice::UserKey};
+        ConfigureFunction function{ConfigureFunction::ZCAN_SETVALUE};
+        QByteArray path{};
+        QByteArray value{};
+    };
+
+    /*!
+     * What open() writes to the adapter, made by ZlgCanBackendPrivate::planConfigurations()
+     * whenever a configuration key, the interface or CAN FD changes, so opening a
+     * channel only replays it. A RawFilterKey entry in a phase stands for the
+     * filter commands, which are always sent in full.
+     */
+    struct ConfigurationPlan
+    {
+        std::array<QVector<ConfigurationWrite>, 3> phases{};
+        QVector<ConfigurationWrite> filter{};
+        bool iproperty{false};
+    };
+
+    // IProperty of an open device for the time of one configuration, none for INVALID_DEVICE_HANDLE
+    class IPropertyManager
+    {
+        Q_DISABLE_COPY(IPropertyManager)
+
+    public:
+        explicit IPropertyManager(DEVICE_HANDLE handle);
+        ~IPropertyManager();
+
+        explicit operator bool() const;
+        IProperty* operator->();
+
+    private:
+        IProperty* _iproperty{};
     };
 } //namespace zlg
 
+class ZlgCanReceiver;
+class ZlgCanTransmitter;
+class ZlgCanCyclicSender;
+
 class ZlgCanBackendPrivate
 {
     Q_DECLARE_PUBLIC(ZlgCanBackend)
@@ -186,6 +359,9 @@ class ZlgCanBackendPrivate
     Q_DISABLE_COPY(ZlgCanBackendPrivate)
 
 public:
+    // ms after which a frame whose echo never came back counts as written
+    static constexpr qint64 echo_timeout{1000};
+
     explicit ZlgCanBackendPrivate(ZlgCanBackend* q);
     ~ZlgCanBackendPrivate();
 
@@ -196,15 +372,51 @@ public:
     void setInterfaceName(const QString& interfaceName);
     bool setConfigurationParameter(int key, const QVariant& value);
 
+    bool writeFrame(const QCanBusFrame& frame);
     void startWrite();
     void startRead();
+    void adaptPollInterval(unsigned int backlog);
+
+    void startTransmitting();
+    void stopTransmitting();
+
+    bool scheduleFrames(const QVector<ZlgCanBackend::ScheduledFrame>& frames);
+    void refillSchedule();
+    void cancelSchedule();
+
+    int addCyclicFrame(const QCanBusFrame& frame, int interval, int start_delay);
+    bool updateCyclicFrame(int id, const QByteArray& payload);
+    bool removeCyclicFrame(int id);
+    void clearCyclicFrames();
+    bool setAutoSend(const zlg::CyclicFrame& cyclic_frame, bool enable);
+
+    void startReceiving();
+    void stopReceiving();
+    void drainReceiveRings();
+    void pollChannelErrors(qint64 now);
+    void releaseOrdered(qint64 now, bool flush);
+
+    template<typename T>
+    std::size_t receive(const T* data, std::size_t size);
+    template<typename T>
+    bool consumeEcho(const T&);
+    bool consumeEcho(const ZCANDataObj& data);
+    std::size_t echoRoom() const;
+    void expireEchoes();
+    void resumeWrite();
+    void flushReceived();
+    qint64 readRawFrames(const std::function<void(std::span<const ZlgCanBackend::RawFrame>)>& visitor);
 
     void resetController();
 
     QCanBusDevice::CanBusStatus busStatus();
 
 private:
-    bool setConfigurations(int order);
+    bool startChannel();
+    bool restartChannel();
+    void planConfigurations();
+    bool setConfigurations(int order, zlg::IPropertyManager& iproperty);
+    bool setFilterRanges();
     const QString& systemErrorString(int* errorCode = nullptr);
 
 private:
@@ -217,11 +429,72 @@ private:
     CHANNEL_HANDLE _channel_handle{INVALID_CHANNEL_HANDLE};
 
     bool _fd_enabled{false};
+    bool _merge_receive{false};
+    bool _transmit_data{false};
+    bool _tx_echo{false};
+    bool _receive_own{false};
     QHash<QCanBusDevice::ConfigurationKey, QVariant> _configurations{};
+    zlg::ConfigurationPlan _configuration_plan{};
+    zlg::FrameFilter _filter{};
+    QCanBusFrame::FrameErrors _error_filter{QCanBusFrame::AnyError};
+    bool _poll_errors{false};
+    qint64 _error_poll_time{0};
 
     QTimer _read_timer{};
+    bool _adaptive_poll{false};
+    int _poll_interval_min{1};
+    int _poll_interval_max{100};
     QTimer _write_timer{};
-    QMutex _mutex{};
+    zlg::ChannelMutex _rx_mutex{};
+    zlg::ChannelMutex _tx_mutex{};
+    zlg::ChannelMutex _control_mutex{};
+    zlg::ChannelMutex* _device_tx_mutex{};
+    zlg::ChannelErrors _channel_errors{};
+    zlg::PerformanceCounters _counters{};
+
+    ZlgCanTransmitter* _transmitter{};
+    zlg::MpscQueue<QCanBusFrame> _transmit_queue{};
+    int _transmit_timeout{0};
+
+    zlg::TransmitSchedule _schedule{};
+    QTimer _schedule_timer{};
+    qint64 _schedule_lead{0};
+
+    QHash<int, zlg::CyclicFrame> _cyclic_frames{};
+    int _next_cyclic_id{0};
+    ZlgCanCyclicSender* _cyclic_sender{};
+
+    ZlgCanReceiver* _receiver{};
+    zlg::SpscRing<ZCAN_Receive_Data> _ring{};
+    zlg::SpscRing<ZCAN_ReceiveFD_Data> _fd_ring{};
+    zlg::SpscRing<ZCANDataObj> _data_ring{};
+    zlg::ReceiveSubscriber _subscriber{};
+    bool _subscribed{false};
+
+    bool _reordering{false};
+    qint64 _reorder_window{0};
+    QTimer _reorder_timer{};
+    zlg::ReorderQueue<ZCAN_Receive_Data> _reorder{};
+    zlg::ReorderQueue<ZCAN_ReceiveFD_Data> _fd_reorder{};
+
+    QElapsedTimer _clock{};
+    zlg::LatencyHistogram _latency_histogram{};
+    zlg::LatencyHistogram _tx_latency_histogram{};
+    zlg::SpscRing<zlg::PendingEcho> _pending_echoes{};
+    quint32 _echo_sequence{0};
+    qint64 _frames_echoed{0};
+    QTimer _echo_timer{};
+
+    QCanBusFrame _frame{};
+    QVector<QCanBusFrame> _received_frames{};
+    zlg::PayloadPool _payload_pool{};
+
+    bool _raw_frames_enabled{false};
+    QVector<ZlgCanBackend::RawFrame> _raw_batch{};
+    QVector<QVector<ZlgCanBackend::RawFrame>> _raw_batches{};
+    QVector<QVector<ZlgCanBackend::RawFrame>> _raw_pool{};
+    qsizetype _raw_pending{0};
+    qsizetype _raw_capacity{4096};
 
     const zlg::Device* device{};
     const zlg::Loader* dll{};
@@ -0,0 +1,116 @@
+#include "zlgcancounters_p.h"
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    void PerformanceCounters::record(ZlgCanBackend::VendorFunction function, qint64 nsecs)
+    {
+        _calls[function].fetch_add(1, std::memory_order_relaxed);
+        _call_time[function].fetch_add(static_cast<quint64>(nsecs), std::memory_order_relaxed);
+    }
+
+    void PerformanceCounters::received(quint64 frames, quint64 bytes)
+    {
+        _frames_received.fetch_add(frames, std::memory_order_relaxed);
+        _bytes_received.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void PerformanceCounters::receive_batch(std::size_t size)
+    {
+        batch(_receive_batches, size);
+    }
+
+    void PerformanceCounters::error(unsigned int error_code)
+    {
+        if((ZCAN_ERROR_CAN_BUFFER_OVERFLOW | ZCAN_ERROR_BUFFEROVERFLOW) & error_code)
+        {
+            _buffer_overflows.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void PerformanceCounters::error(const ZCANErrorData& data)
+    {
+        const auto controller{ZCAN_ERR_TYPE_CONTROLLER_ERR == data.errType && (ZCAN_CONTROLLER_RX_FIFO_OVERFLOW == data.errSubType || ZCAN_CONTROLLER_DRIVER_RX_BUFFER_OVERFLOW == data.errSubType || ZCAN_CONTROLLER_DRIVER_TX_BUFFER_OVERFLOW == data.errSubType)};
+        const auto device{ZCAN_ERR_TYPE_DEVICE_ERR == data.errType && (ZCAN_DEVICE_APP_RX_BUFFER_OVERFLOW == data.errSubType || ZCAN_DEVICE_APP_TX_BUFFER_OVERFLOW == data.errSubType)};
+        if(controller || device)
+        {
+            _buffer_overflows.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void PerformanceCounters::raw_dropped(quint64 frames)
+    {
+        _raw_frames_dropped.fetch_add(frames, std::memory_order_relaxed);
+    }
+
+    void PerformanceCounters::enqueued(qint64 nsecs)
+    {
+        _enqueue_calls.fetch_add(1, std::memory_order_relaxed);
+        _enqueue_time.fetch_add(static_cast<quint64>(nsecs), std::memory_order_relaxed);
+    }
+
+    ZlgCanBackend::PerformanceCounters PerformanceCounters::snapshot() const
+    {
+        ZlgCanBackend::PerformanceCounters counters{};
+        counters.framesReceived = _frames_received.load(std::memory_order_relaxed);
+        counters.bytesReceived = _bytes_received.load(std::memory_order_relaxed);
+        counters.framesTransmitted = _frames_transmitted.load(std::memory_order_relaxed);
+        counters.bytesTransmitted = _bytes_transmitted.load(std::memory_order_relaxed);
+        counters.bufferOverflows = _buffer_overflows.load(std::memory_order_relaxed);
+        counters.rawFramesDropped = _raw_frames_dropped.load(std::memory_order_relaxed);
+        counters.enqueueCalls = _enqueue_calls.load(std::memory_order_relaxed);
+        counters.enqueueTime = _enqueue_time.load(std::memory_order_relaxed);
+        for(auto i{0}; i < ZlgCanBackend::VendorFunctionCount; ++i)
+        {
+            counters.vendorCalls[i].calls = _calls[i].load(std::memory_order_relaxed);
+            counters.vendorCalls[i].time = _call_time[i].load(std::memory_order_relaxed);
+        }
+        counters.receiveBatchSizes.resize(batch_buckets);
+        counters.transmitBatchSizes.resize(batch_buckets);
+        for(auto i{0}; i < batch_buckets; ++i)
+        {
+            counters.receiveBatchSizes[i] = _receive_batches[i].load(std::memory_order_relaxed);
+            counters.transmitBatchSizes[i] = _transmit_batches[i].load(std::memory_order_relaxed);
+        }
+        return counters;
+    }
+
+    void PerformanceCounters::reset()
+    {
+        _frames_received.store(0, std::memory_order_relaxed);
+        _bytes_received.store(0, std::memory_order_relaxed);
+        _frames_transmitted.store(0, std::memory_order_relaxed);
+        _bytes_transmitted.store(0, std::memory_order_relaxed);
+        _buffer_overflows.store(0, std::memory_order_relaxed);
+        _raw_frames_dropped.store(0, std::memory_order_relaxed);
+        _enqueue_calls.store(0, std::memory_order_relaxed);
+        _enqueue_time.store(0, std::memory_order_relaxed);
+        for(auto i{0}; i < ZlgCanBackend::VendorFunctionCount; ++i)
+        {
+            _calls[i].store(0, std::memory_order_relaxed);
+            _call_time[i].store(0, std::memory_order_relaxed);
+        }
+        for(auto i{0}; i < batch_buckets; ++i)
+        {
+            _receive_batches[i].store(0, std::memory_order_relaxed);
+            _transmit_batches[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void PerformanceCounters::batch(std::atomic<quint64>* buckets, std::size_t size)
+    {
+        if(!size)
+        {
+            return;
+        }
+        auto bucket{0};
+        while(bucket < batch_buckets - 1 && size >> (bucket + 1))
+        {
+            ++bucket;
+        }
+        buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+} //namespace zlg
+
+QT_END_NAMESPACE
@@ -0,0 +1,101 @@
+#ifndef ZLGCANCOUNTERS_P_H
+#define ZLGCANCOUNTERS_P_H
+
+#include "zlgcanbackend.h"
+
+#include <QElapsedTimer>
+
+#include <zlgcan/zlgcan.h>
+
+#include <atomic>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    inline unsigned int payload_length(const ZCAN_Transmit_Data& data)
+    {
+        return data.frame.can_dlc;
+    }
+
+    inline unsigned int payload_length(const ZCAN_TransmitFD_Data& data)
+    {
+        return data.frame.len;
+    }
+
+    inline unsigned int payload_length(const ZCANDataObj& data)
+    {
+        return data.data.zcanCANFDData.frame.len;
+    }
+
+    /*!
+     * Hot path counters of one channel. Every update is a relaxed atomic add, so the
+     * receive, transmit and cyclic threads share one instance without locking, and
+     * snapshot() may be called from any thread. Calls made by the device-wide receive
+     * engine are counted by every channel subscribed to it.
+     */
+    class PerformanceCounters
+    {
+        PerformanceCounters(const PerformanceCounters&) = delete;
+        PerformanceCounters& operator=(const PerformanceCounters&) = delete;
+
+    public:
+        static constexpr int batch_buckets{8};
+
+        PerformanceCounters() = default;
+
+        template<typename F>
+        auto call(ZlgCanBackend::VendorFunction function, F&& f)
+        {
+            QElapsedTimer timer{};
+            timer.start();
+            const auto result{f()};
+            record(function, timer.nsecsElapsed());
+            return result;
+        }
+
+        void record(ZlgCanBackend::VendorFunction function, qint64 nsecs);
+        void received(quint64 frames, quint64 bytes);
+        void receive_batch(std::size_t size);
+        void error(unsigned int error_code);
+        void error(const ZCANErrorData& data);
+        void raw_dropped(quint64 frames);
+        void enqueued(qint64 nsecs);
+
+        template<typename T>
+        void transmitted(const T* data, std::size_t size)
+        {
+            auto bytes{quint64{0}};
+            for(auto i{std::size_t{0}}; i < size; ++i)
+            {
+                bytes += payload_length(data[i]);
+            }
+            _frames_transmitted.fetch_add(size, std::memory_order_relaxed);
+            _bytes_transmitted.fetch_add(bytes, std::memory_order_relaxed);
+            batch(_transmit_batches, size);
+        }
+
+        ZlgCanBackend::PerformanceCounters snapshot() const;
+        void reset();
+
+    private:
+        static void batch(std::atomic<quint64>* buckets, std::size_t size);
+
+        std::atomic<quint64> _frames_received{0};
+        std::atomic<quint64> _bytes_received{0};
+        std::atomic<quint64> _frames_transmitted{0};
+        std::atomic<quint64> _bytes_transmitted{0};
+        std::atomic<quint64> _buffer_overflows{0};
+        std::atomic<quint64> _raw_frames_dropped{0};
+        std::atomic<quint64> _enqueue_calls{0};
+        std::atomic<quint64> _enqueue_time{0};
+        std::atomic<quint64> _calls[ZlgCanBackend::VendorFunctionCount]{};
+        std::atomic<quint64> _call_time[ZlgCanBackend::VendorFunctionCount]{};
+        std::atomic<quint64> _receive_batches[batch_buckets]{};
+        std::atomic<quint64> _transmit_batches[batch_buckets]{};
+    };
+} //namespace zlg
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANCOUNTERS_P_H
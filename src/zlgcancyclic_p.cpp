@@ -0,0 +1,149 @@
+#include "zlgcancyclic_p.h"
+
+#include <QDeadlineTimer>
+
+QT_BEGIN_NAMESPACE
+
+ZlgCanCyclicSender::ZlgCanCyclicSender(const zlg::Loader* dll, const Context& context, QObject* parent): QThread(parent), dll(dll), _context(context)
+{
+}
+
+ZlgCanCyclicSender::~ZlgCanCyclicSender()
+{
+    stop();
+}
+
+void ZlgCanCyclicSender::insert(int id, const QCanBusFrame& frame, int interval, int start_delay)
+{
+    Entry entry{};
+    entry.frame = frame;
+    zlg::to_transmit_data(frame, entry.data);
+    zlg::to_transmit_data(frame, entry.fd_data);
+    entry.interval = qMax(interval, 1) * qint64{1000};
+    entry.due = _context.clock->nsecsElapsed() / 1000 + qMax(start_delay, 0) * qint64{1000};
+
+    const QMutexLocker locker{&_entries_mutex};
+    _entries.insert(id, entry);
+    _changed.wakeAll();
+}
+
+bool ZlgCanCyclicSender::update(int id, const QByteArray& payload)
+{
+    const QMutexLocker locker{&_entries_mutex};
+    if(!_entries.contains(id))
+    {
+        return false;
+    }
+    auto& entry{_entries[id]};
+    entry.frame.setPayload(payload);
+    zlg::to_transmit_data(entry.frame, entry.data);
+    zlg::to_transmit_data(entry.frame, entry.fd_data);
+    return true;
+}
+
+bool ZlgCanCyclicSender::remove(int id)
+{
+    const QMutexLocker locker{&_entries_mutex};
+    const auto result{_entries.remove(id) > 0};
+    _changed.wakeAll();
+    return result;
+}
+
+void ZlgCanCyclicSender::stop()
+{
+    requestInterruption();
+    {
+        const QMutexLocker locker{&_entries_mutex};
+        _changed.wakeAll();
+    }
+    wait();
+}
+
+void ZlgCanCyclicSender::run()
+{
+    ZCAN_Transmit_Data data[64]{};
+    ZCAN_TransmitFD_Data fd_data[64]{};
+    constexpr auto data_size{sizeof(data) / sizeof(data[0])};
+
+    QMutexLocker locker{&_entries_mutex};
+    while(!isInterruptionRequested())
+    {
+        if(_entries.isEmpty())
+        {
+            _changed.wait(&_entries_mutex);
+            continue;
+        }
+
+        auto now{_context.clock->nsecsElapsed() / 1000};
+        auto due{std::numeric_limits<qint64>::max()};
+        for(auto iter{_entries.cbegin()}; iter != _entries.cend(); ++iter)
+        {
+            due = qMin(due, iter.value().due);
+        }
+
+        const auto remaining{due - now};
+        if(remaining > spin_time)
+        {
+            _changed.wait(&_entries_mutex, QDeadlineTimer{(remaining - spin_time) / 1000});
+            continue;
+        }
+        if(remaining > 0)
+        {
+            locker.unlock();
+            QThread::yieldCurrentThread();
+            locker.relock();
+            continue;
+        }
+
+        auto len{std::size_t{0}};
+        auto fd_len{std::size_t{0}};
+        for(auto iter{_entries.begin()}; iter != _entries.end(); ++iter)
+        {
+            auto& entry{iter.value()};
+            if(entry.due > now)
+            {
+                continue;
+            }
+            if(entry.frame.hasFlexibleDataRateFormat())
+            {
+                if(fd_len == data_size)
+                {
+                    continue;
+                }
+                fd_data[fd_len++] = entry.fd_data;
+            }
+            else
+            {
+                if(len == data_size)
+                {
+                    continue;
+                }
+                data[len++] = entry.data;
+            }
+            // periods missed while late are skipped, the phase stays where it was
+            entry.due += ((now - entry.due) / entry.interval + 1) * entry.interval;
+        }
+
+        locker.unlock();
+        {
+            const zlg::ChannelLocker channel_locker{*_context.tx_mutex};
+            if(len)
+            {
+                const auto result{_context.counters->call(ZlgCanBackend::TransmitFunction, [&]() {
+                    return dll->ZCAN_Transmit(_context.channel_handle, data, static_cast<UINT>(len));
+                })};
+                _context.counters->transmitted(data, result);
+            }
+            if(fd_len)
+            {
+                const auto result{_context.counters->call(ZlgCanBackend::TransmitFDFunction, [&]() {
+                    return dll->ZCAN_TransmitFD(_context.channel_handle, fd_data, static_cast<UINT>(fd_len));
+                })};
+                _context.counters->transmitted(fd_data, result);
+            }
+        }
+        locker.relock();
+    }
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,68 @@
+#ifndef ZLGCANCYCLIC_P_H
+#define ZLGCANCYCLIC_P_H
+
+#include "zlgcanbackend_p.h"
+
+#include <QCanBusFrame>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * Host-side replacement for the device's auto_send objects. Sleeps on a wait
+ * condition until shortly before the next frame is due and yields for the rest,
+ * which keeps the period accurate without depending on the system timer
+ * resolution. A late frame keeps its phase instead of being sent in bursts.
+ */
+class ZlgCanCyclicSender: public QThread
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(ZlgCanCyclicSender)
+
+public:
+    struct Context
+    {
+        CHANNEL_HANDLE channel_handle{INVALID_CHANNEL_HANDLE};
+        zlg::ChannelMutex* tx_mutex{};
+        const QElapsedTimer* clock{};
+        zlg::PerformanceCounters* counters{};
+    };
+
+    static constexpr qint64 spin_time{1000};
+
+    explicit ZlgCanCyclicSender(const zlg::Loader* dll, const Context& context, QObject* parent = nullptr);
+    ~ZlgCanCyclicSender();
+
+    void insert(int id, const QCanBusFrame& frame, int interval, int start_delay);
+    bool update(int id, const QByteArray& payload);
+    bool remove(int id);
+    void stop();
+
+protected:
+    void run() override;
+
+private:
+    struct Entry
+    {
+        QCanBusFrame frame{};
+        ZCAN_Transmit_Data data{};
+        ZCAN_TransmitFD_Data fd_data{};
+        qint64 interval{0};
+        qint64 due{0};
+    };
+
+    const zlg::Loader* dll{};
+    Context _context{};
+
+    QMutex _entries_mutex{};
+    QWaitCondition _changed{};
+    QHash<int, Entry> _entries{};
+};
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANCYCLIC_P_H
@@ -0,0 +1,298 @@
+#include "zlgcandevices_p.h"
+
+#include "zlgcandevices_table.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QLoggingCategory>
+#include <QVector>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_CANBUS_PLUGINS_ZLGCAN)
+
+namespace zlg
+{
+    // ZLG device types are small numbers, so they index the table directly
+    constexpr unsigned int device_types{256};
+
+    // storage behind the views of a device read at runtime
+    struct DeviceOverride
+    {
+        QByteArray name{};
+        QVector<unsigned int> bitrate{};
+        QVector<unsigned int> data_field_bitrate{};
+        Device device{};
+    };
+
+    struct DeviceTable
+    {
+        std::array<const Device*, device_types> by_type{};
+        QList<const Device*> devices{};
+        std::deque<DeviceOverride> overrides{};
+        // the generated names, unless devices were read at runtime
+        std::span<const DeviceName> names{builtin::device_names};
+        std::vector<DeviceName> override_names{};
+    };
+
+    void read_devices(QIODevice& file, std::deque<DeviceOverride>& overrides)
+    {
+        QXmlStreamReader devices_xml_reader(&file);
+
+        auto read_bitrate = [](QXmlStreamReader& xml, QVector<unsigned int>& bitRate) {
+            while(xml.readNextStartElement())
+            {
+                if("VALUE" == xml.name().toString().toUpper())
+                {
+                    auto value{xml.readElementText().toUInt()};
+                    if(value)
+                    {
+                        bitRate << value;
+                    }
+                }
+            }
+        };
+
+        auto read_key = [](QXmlStreamReader& xml, Configuration& configuration) {
+            configuration.configurable = ("TRUE" == xml.attributes().value("configurable").toString().toUpper());
+
+            if("ZCAN_INITCAN" == xml.attributes().value("method").toString().toUpper())
+            {
+                configuration.function = ConfigureFunction::ZCAN_INITCAN;
+            }
+            else if("ZCAN_SETVALUE" == xml.attributes().value("method").toString().toUpper())
+            {
+                configuration.function = ConfigureFunction::ZCAN_SETVALUE;
+            }
+            else if("IPROPERTY_SETVALUE" == xml.attributes().value("method").toString().toUpper())
+            {
+                configuration.function = ConfigureFunction::IPROPERTY_SETVALUE;
+            }
+
+            if("BEFORE_INIT_CAN" == xml.attributes().value("sequence").toString().toUpper())
+            {
+                configuration.order = ConfigureOrder::BEFORE_INIT_CAN;
+            }
+            else if("BEFORE_START_CAN" == xml.attributes().value("sequence").toString().toUpper())
+            {
+                configuration.order = ConfigureOrder::BEFORE_START_CAN;
+            }
+            else if("AFTER_START_CAN" == xml.attributes().value("sequence").toString().toUpper())
+            {
+                configuration.order = ConfigureOrder::AFTER_START_CAN;
+            }
+        };
+
+        static const struct
+        {
+            const char* name;
+            QCanBusDevice::ConfigurationKey key;
+        } keys[]{
+            {"RAWFILTER", QCanBusDevice::RawFilterKey},
+            {"ERRORFILTER", QCanBusDevice::ErrorFilterKey},
+            {"LOOPBACK", QCanBusDevice::LoopbackKey},
+            {"RECEIVEOWN", QCanBusDevice::ReceiveOwnKey},
+            {"BITRATE", QCanBusDevice::BitRateKey},
+            {"CANFD", QCanBusDevice::CanFdKey},
+            {"DATABITRATE", QCanBusDevice::DataBitRateKey},
+        };
+
+        auto read_configuration = [&](DeviceOverride& device) {
+            while(devices_xml_reader.readNextStartElement())
+            {
+                if(devices_xml_reader.attributes().hasAttribute("configurable") && ("FALSE" == devices_xml_reader.attributes().value("configurable").toString().toUpper()))
+                {
+                    devices_xml_reader.skipCurrentElement();
+                    continue;
+                }
+
+                auto keyName{devices_xml_reader.name().toString().toUpper()};
+                const auto key{std::find_if(std::begin(keys), std::end(keys), [&](const auto& key) {
+                    return keyName == key.name;
+                })};
+                if(std::end(keys) == key)
+                {
+                    devices_xml_reader.skipCurrentElement();
+                    continue;
+                }
+
+                auto& configuration = device.device.configurations[key->key];
+                configuration.key = key->key;
+                read_key(devices_xml_reader, configuration);
+                if(QCanBusDevice::BitRateKey == key->key)
+                {
+                    read_bitrate(devices_xml_reader, device.bitrate);
+                }
+                else if(QCanBusDevice::DataBitRateKey == key->key)
+                {
+                    read_bitrate(devices_xml_reader, device.data_field_bitrate);
+                }
+                else
+                {
+                    devices_xml_reader.skipCurrentElement();
+                }
+            }
+        };
+
+        auto read_configurations = [&](DeviceOverride& device) {
+            while(devices_xml_reader.readNextStartElement())
+            {
+                if("CONFIGURATIONS" == devices_xml_reader.name().toString().toUpper())
+                {
+                    read_configuration(device);
+                }
+                else
+                {
+                    devices_xml_reader.skipCurrentElement();
+                }
+            }
+        };
+
+        auto read_device = [&](DeviceOverride& device) {
+            device.name = devices_xml_reader.attributes().value("name").toString().toUpper().toLatin1();
+            device.device.type = devices_xml_reader.attributes().value("type").toUInt();
+            device.device.fd = ("TRUE" == devices_xml_reader.attributes().value("fd").toLatin1().toUpper());
+            device.device.channels = devices_xml_reader.attributes().value("channels").toUInt();
+            device.device.merge_receive = ("TRUE" == devices_xml_reader.attributes().value("merge_receive").toLatin1().toUpper());
+            device.device.transmit_data = ("TRUE" == devices_xml_reader.attributes().value("transmit_data").toLatin1().toUpper());
+            device.device.delay_send = ("TRUE" == devices_xml_reader.attributes().value("delay_send").toLatin1().toUpper());
+            device.device.auto_send = devices_xml_reader.attributes().value("auto_send").toUInt();
+            device.device.filters = devices_xml_reader.attributes().value("filters").toUInt();
+            read_configurations(device);
+
+            // the views are only taken once the storage behind them is complete
+            device.device.name = std::string_view(device.name.constData(), static_cast<std::size_t>(device.name.size()));
+            device.device.bitrate = std::span<const unsigned int>(device.bitrate.constData(), static_cast<std::size_t>(device.bitrate.size()));
+            device.device.data_field_bitrate = std::span<const unsigned int>(device.data_field_bitrate.constData(), static_cast<std::size_t>(device.data_field_bitrate.size()));
+        };
+
+        while(devices_xml_reader.readNextStartElement())
+        {
+            if("DEVICES" == devices_xml_reader.name().toString().toUpper())
+            {
+                while(devices_xml_reader.readNextStartElement())
+                {
+                    if("DEVICE" == devices_xml_reader.name().toString().toUpper())
+                    {
+                        read_device(overrides.emplace_back());
+                    }
+                    else
+                    {
+                        devices_xml_reader.skipCurrentElement();
+                    }
+                }
+            }
+            else
+            {
+                devices_xml_reader.skipCurrentElement();
+            }
+        }
+    }
+
+    void add_device(DeviceTable& table, const Device& device)
+    {
+        if(!device.type || device.type >= device_types)
+        {
+            qCWarning(QT_CANBUS_PLUGINS_ZLGCAN, "Ignoring device %.*s of type %u.", static_cast<int>(device.name.size()), device.name.data(), device.type);
+            return;
+        }
+        auto& slot{table.by_type[device.type]};
+        if(slot)
+        {
+            table.devices.removeOne(slot);
+        }
+        slot = &device;
+        table.devices.append(&device);
+    }
+
+    const DeviceTable& get_device_table()
+    {
+        // a function local static is initialized exactly once, even when the first calls race
+        static const DeviceTable table{[]() {
+            DeviceTable device_table{};
+            for(const auto& device: builtin::devices)
+            {
+                add_device(device_table, device);
+            }
+
+            const auto file_name{qEnvironmentVariable("ZLGCAN_DEVICES")};
+            if(!file_name.isEmpty())
+            {
+                QFile file(file_name);
+                if(file.open(QFile::ReadOnly))
+                {
+                    read_devices(file, device_table.overrides);
+                    for(const auto& device: device_table.overrides)
+                    {
+                        add_device(device_table, device.device);
+                    }
+                    for(const auto* device: device_table.devices)
+                    {
+                        device_table.override_names.push_back({device->name, device->type});
+                    }
+                    std::sort(device_table.override_names.begin(), device_table.override_names.end(), [](const auto& lhs, const auto& rhs) {
+                        return lhs.name < rhs.name;
+                    });
+                    device_table.names = device_table.override_names;
+                }
+                else
+                {
+                    qCWarning(QT_CANBUS_PLUGINS_ZLGCAN, "Cannot read devices from %ls, using the built-in devices only.", qUtf16Printable(file_name));
+                }
+            }
+            return device_table;
+        }()};
+        return table;
+    }
+
+    bool contains(std::span<const unsigned int> values, unsigned int value)
+    {
+        return values.end() != std::find(values.begin(), values.end(), value);
+    }
+
+    const Device& get_device(unsigned int type)
+    {
+        static constexpr Device none{};
+        const auto& by_type{get_device_table().by_type};
+        return type < device_types && by_type[type] ? *by_type[type] : none;
+    }
+
+    // device names are upper case ASCII, so the name asked for is folded character by character instead of copied
+    static int compare_name(std::string_view name, const QString& device_name)
+    {
+        const auto size{std::min<std::size_t>(name.size(), static_cast<std::size_t>(device_name.size()))};
+        for(auto i{std::size_t{0}}; i < size; ++i)
+        {
+            auto c{device_name[static_cast<int>(i)].unicode()};
+            c = c >= 'a' && c <= 'z' ? c - ('a' - 'A') : c;
+            const auto n{static_cast<unsigned char>(name[i])};
+            if(n != c)
+            {
+                return n < c ? -1 : 1;
+            }
+        }
+        return name.size() < static_cast<std::size_t>(device_name.size()) ? -1 : name.size() > static_cast<std::size_t>(device_name.size()) ? 1 : 0;
+    }
+
+    unsigned int get_device_type(const QString& device_name)
+    {
+        const auto& names{get_device_table().names};
+        const auto found{std::lower_bound(names.begin(), names.end(), device_name, [](const DeviceName& entry, const QString& name) {
+            return compare_name(entry.name, name) < 0;
+        })};
+        // a type the table ignored has no device behind its name
+        return found != names.end() && 0 == compare_name(found->name, device_name) ? get_device(found->type).type : 0;
+    }
+
+    const QList<const Device*>& get_devices()
+    {
+        return get_device_table().devices;
+    }
+} //namespace zlg
+
+QT_END_NAMESPACE
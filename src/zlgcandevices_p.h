@@ -0,0 +1,88 @@
+#ifndef ZLGCANDEVICES_P_H
+#define ZLGCANDEVICES_P_H
+
+#include <QCanBusDevice>
+#include <QList>
+#include <QString>
+
+#include <array>
+#include <span>
+#include <string_view>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    enum class ConfigureFunction
+    {
+        ZCAN_INITCAN,
+        ZCAN_SETVALUE,
+        IPROPERTY_SETVALUE,
+    };
+
+    enum class ConfigureOrder
+    {
+        BEFORE_INIT_CAN,
+        BEFORE_START_CAN,
+        AFTER_START_CAN,
+    };
+
+    struct Configuration
+    {
+        QCanBusDevice::ConfigurationKey key{QCanBusDevice::UserKey};
+        bool configurable{false};
+        ConfigureFunction function{ConfigureFunction::ZCAN_SETVALUE};
+        ConfigureOrder order{ConfigureOrder::BEFORE_INIT_CAN};
+    };
+
+    // devices.xml describes the standard keys RawFilterKey to DataBitRateKey
+    constexpr int configuration_keys{QCanBusDevice::DataBitRateKey + 1};
+
+    /*!
+     * Capabilities of one adapter type. The built-in devices are a constexpr table
+     * generated from devices.xml at build time (cmake/zlgcandevices.cmake), so a
+     * lookup neither parses nor allocates. Devices read from the file named by the
+     * ZLGCAN_DEVICES environment variable are added to it, or replace built-in
+     * devices of the same type, when the table is first used.
+     */
+    struct Device
+    {
+        std::string_view name{};
+        unsigned int type{0};
+        bool fd{false};
+        unsigned int channels{0};
+        bool merge_receive{false};
+        bool transmit_data{false};
+        bool delay_send{false};
+        unsigned int auto_send{0};
+        unsigned int filters{0};
+        std::array<Configuration, configuration_keys> configurations{};
+        std::span<const unsigned int> bitrate{};
+        std::span<const unsigned int> data_field_bitrate{};
+
+        // nullptr unless devices.xml marks the key configurable
+        constexpr const Configuration* configuration(int key) const
+        {
+            return key >= 0 && key < configuration_keys && configurations[key].configurable ? &configurations[key] : nullptr;
+        }
+    };
+
+    // upper case, sorted by name in byte order
+    struct DeviceName
+    {
+        std::string_view name{};
+        unsigned int type{0};
+    };
+
+    bool contains(std::span<const unsigned int> values, unsigned int value);
+
+    // an empty device for unknown types
+    const Device& get_device(unsigned int type);
+    // case-insensitive binary search of the sorted names, 0 for unknown names
+    unsigned int get_device_type(const QString& device_name);
+    const QList<const Device*>& get_devices();
+} //namespace zlg
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANDEVICES_P_H
@@ -0,0 +1,95 @@
+#include "zlgcanengine_p.h"
+
+QT_BEGIN_NAMESPACE
+
+ZlgCanReceiveEngine::ZlgCanReceiveEngine(const zlg::Loader* dll, DEVICE_HANDLE device_handle, int wait_time, QObject* parent):
+    QThread(parent), dll(dll), _device_handle(device_handle), _wait_time(qMax(wait_time, 1))
+{
+}
+
+ZlgCanReceiveEngine::~ZlgCanReceiveEngine()
+{
+    stop();
+}
+
+void ZlgCanReceiveEngine::subscribe(unsigned int channel, zlg::ReceiveSubscriber* subscriber)
+{
+    const QMutexLocker locker{&_subscribers_mutex};
+    if(channel < max_channels)
+    {
+        _subscriber_count += _subscribers[channel] ? 0 : 1;
+        _subscribers[channel] = subscriber;
+    }
+}
+
+bool ZlgCanReceiveEngine::unsubscribe(unsigned int channel)
+{
+    // records are only pushed while the lock is held, so nothing reaches the ring after this returns
+    const QMutexLocker locker{&_subscribers_mutex};
+    if(channel < max_channels && _subscribers[channel])
+    {
+        _subscribers[channel] = nullptr;
+        --_subscriber_count;
+    }
+    return _subscriber_count > 0;
+}
+
+void ZlgCanReceiveEngine::stop()
+{
+    requestInterruption();
+    wait();
+}
+
+void ZlgCanReceiveEngine::run()
+{
+    ZCANDataObj data_obj[64]{};
+    constexpr auto data_obj_size{sizeof(data_obj) / sizeof(data_obj[0])};
+
+    while(!isInterruptionRequested())
+    {
+        QElapsedTimer timer{};
+        timer.start();
+        const auto result{dll->ZCAN_ReceiveData(_device_handle, data_obj, data_obj_size, _wait_time)};
+        const auto elapsed{timer.nsecsElapsed()};
+
+        bool pushed[max_channels]{};
+        std::size_t counts[max_channels]{};
+        const QMutexLocker locker{&_subscribers_mutex};
+        // records arrive in runs of the same channel, each run is pushed at once
+        for(auto begin{0U}, end{0U}; begin < result; begin = end)
+        {
+            const auto channel{data_obj[begin].chnl};
+            for(end = begin + 1; end < result && data_obj[end].chnl == channel; ++end)
+            {
+            }
+            if(auto* subscriber{_subscribers[channel]})
+            {
+                for(auto i{begin}; i < end; ++i)
+                {
+                    if(ZCAN_DT_ZCAN_ERROR_DATA == data_obj[i].dataType)
+                    {
+                        subscriber->counters->error(data_obj[i].data.zcanErrData);
+                    }
+                }
+                pushed[channel] = subscriber->ring->push(data_obj + begin, end - begin) || pushed[channel];
+                counts[channel] += end - begin;
+            }
+        }
+        for(auto channel{0}; channel < max_channels; ++channel)
+        {
+            auto* subscriber{_subscribers[channel]};
+            if(!subscriber)
+            {
+                continue;
+            }
+            subscriber->counters->record(ZlgCanBackend::ReceiveDataFunction, elapsed);
+            subscriber->counters->receive_batch(counts[channel]);
+            if(pushed[channel] && !subscriber->notified.exchange(true, std::memory_order_acq_rel))
+            {
+                subscriber->notify();
+            }
+        }
+    }
+}
+
+QT_END_NAMESPACE
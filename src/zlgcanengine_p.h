@@ -0,0 +1,49 @@
+#ifndef ZLGCANENGINE_P_H
+#define ZLGCANENGINE_P_H
+
+#include "zlgcanbackend_p.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QThread>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * Drains every channel of one adapter with a single blocking ZCAN_ReceiveData
+ * call per cycle and demultiplexes the records by ZCANDataObj::chnl into the
+ * rings of the subscribed backends. Records of channels nobody subscribed to
+ * are dropped. Each subscriber is notified once per batch that finds it idle,
+ * like ZlgCanReceiver does.
+ */
+class ZlgCanReceiveEngine: public QThread
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(ZlgCanReceiveEngine)
+
+public:
+    static constexpr int max_channels{256};
+
+    explicit ZlgCanReceiveEngine(const zlg::Loader* dll, DEVICE_HANDLE device_handle, int wait_time, QObject* parent = nullptr);
+    ~ZlgCanReceiveEngine();
+
+    void subscribe(unsigned int channel, zlg::ReceiveSubscriber* subscriber);
+    bool unsubscribe(unsigned int channel);
+    void stop();
+
+protected:
+    void run() override;
+
+private:
+    const zlg::Loader* dll{};
+    DEVICE_HANDLE _device_handle{INVALID_DEVICE_HANDLE};
+    int _wait_time{0};
+
+    QMutex _subscribers_mutex{};
+    zlg::ReceiveSubscriber* _subscribers[max_channels]{};
+    int _subscriber_count{0};
+};
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANENGINE_P_H
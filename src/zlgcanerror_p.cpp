@@ -0,0 +1,313 @@
+#include "zlgcanerror_p.h"
+
+#include <QByteArray>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    namespace error
+    {
+        // the node state tells which limit was crossed, the larger counter tells by which side
+        static void node_state(const ZCANErrorData& data, Frame& frame)
+        {
+            const auto rx_side{data.rxErrCount >= data.txErrCount};
+            switch(data.nodeState)
+            {
+                // SocketCAN reports the return to error active as a controller problem too
+                case ZCAN_NODE_STATE_ACTIVE:
+                    frame.error_class |= QCanBusFrame::ControllerError;
+                    frame.payload[1] |= crtl_active;
+                    break;
+                case ZCAN_NODE_STATE_WARNNING:
+                    frame.error_class |= QCanBusFrame::ControllerError;
+                    frame.payload[1] |= rx_side ? crtl_rx_warning : crtl_tx_warning;
+                    break;
+                case ZCAN_NODE_STATE_PASSIVE:
+                    frame.error_class |= QCanBusFrame::ControllerError;
+                    frame.payload[1] |= rx_side ? crtl_rx_passive : crtl_tx_passive;
+                    break;
+                case ZCAN_NODE_STATE_BUSOFF: frame.error_class |= QCanBusFrame::BusOffError; break;
+                default: break;
+            }
+        }
+
+        Frame from(const ZCANErrorData& data)
+        {
+            Frame frame{};
+            frame.payload[6] = data.txErrCount;
+            frame.payload[7] = data.rxErrCount;
+
+            switch(data.errType)
+            {
+                case ZCAN_ERR_TYPE_BUS_ERR:
+                {
+                    switch(data.errSubType)
+                    {
+                        case ZCAN_BUS_ERR_BIT_ERR:
+                            frame.error_class = QCanBusFrame::ProtocolViolationError | QCanBusFrame::BusError;
+                            frame.payload[2] = prot_bit;
+                            break;
+                        case ZCAN_BUS_ERR_ACK_ERR:
+                            frame.error_class = QCanBusFrame::MissingAcknowledgmentError | QCanBusFrame::BusError;
+                            frame.payload[3] = prot_loc_ack;
+                            break;
+                        case ZCAN_BUS_ERR_CRC_ERR:
+                            frame.error_class = QCanBusFrame::ProtocolViolationError | QCanBusFrame::BusError;
+                            frame.payload[3] = prot_loc_crc_seq;
+                            break;
+                        case ZCAN_BUS_ERR_FORM_ERR:
+                            frame.error_class = QCanBusFrame::ProtocolViolationError | QCanBusFrame::BusError;
+                            frame.payload[2] = prot_form;
+                            break;
+                        case ZCAN_BUS_ERR_STUFF_ERR:
+                            frame.error_class = QCanBusFrame::ProtocolViolationError | QCanBusFrame::BusError;
+                            frame.payload[2] = prot_stuff;
+                            break;
+                        case ZCAN_BUS_ERR_OVERLOAD_ERR:
+                            frame.error_class = QCanBusFrame::ProtocolViolationError;
+                            frame.payload[2] = prot_overload;
+                            break;
+                        case ZCAN_BUS_ERR_ARBITRATION_LOST:
+                            frame.error_class = QCanBusFrame::LostArbitrationError;
+                            frame.payload[0] = data.errData;
+                            break;
+                        // nodeState is carried by every record, but only a state change report is about it
+                        case ZCAN_BUS_ERR_NODE_STATE_CHAGE: node_state(data, frame); break;
+                        default: break;
+                    }
+                    break;
+                }
+                case ZCAN_ERR_TYPE_CONTROLLER_ERR:
+                {
+                    frame.error_class = QCanBusFrame::ControllerError;
+                    if(ZCAN_CONTROLLER_RX_FIFO_OVERFLOW == data.errSubType || ZCAN_CONTROLLER_DRIVER_RX_BUFFER_OVERFLOW == data.errSubType)
+                    {
+                        frame.payload[1] |= crtl_rx_overflow;
+                    }
+                    else if(ZCAN_CONTROLLER_DRIVER_TX_BUFFER_OVERFLOW == data.errSubType)
+                    {
+                        frame.payload[1] |= crtl_tx_overflow;
+                    }
+                    break;
+                }
+                case ZCAN_ERR_TYPE_DEVICE_ERR:
+                {
+                    frame.error_class = QCanBusFrame::ControllerError;
+                    if(ZCAN_DEVICE_APP_RX_BUFFER_OVERFLOW == data.errSubType)
+                    {
+                        frame.payload[1] |= crtl_rx_overflow;
+                    }
+                    else if(ZCAN_DEVICE_APP_TX_BUFFER_OVERFLOW == data.errSubType)
+                    {
+                        frame.payload[1] |= crtl_tx_overflow;
+                    }
+                    break;
+                }
+                default: frame.error_class = QCanBusFrame::UnknownError; break;
+            }
+
+            return frame;
+        }
+
+        // the SJA1000 registers behind ZCAN_CHANNEL_ERR_INFO, whose segment codes are the SocketCAN locations
+        Frame from(const ZCAN_CHANNEL_ERR_INFO& info)
+        {
+            static constexpr quint8 ecc_types[]{prot_bit, prot_form, prot_stuff, 0};
+
+            Frame frame{};
+            const auto code{info.error_code};
+            // the capture and counters in passive_ErrData are only valid alongside a passive error
+            const auto passive{0 != (ZCAN_ERROR_CAN_PASSIVE & code)};
+            const auto ecc{info.passive_ErrData[0]};
+            const auto rec{info.passive_ErrData[1]};
+            const auto tec{info.passive_ErrData[2]};
+            if(passive)
+            {
+                frame.payload[6] = tec;
+                frame.payload[7] = rec;
+            }
+
+            if((ZCAN_ERROR_CAN_OVERFLOW | ZCAN_ERROR_CAN_BUFFER_OVERFLOW) & code)
+            {
+                frame.error_class |= QCanBusFrame::ControllerError;
+                frame.payload[1] |= crtl_rx_overflow;
+            }
+            if(ZCAN_ERROR_CAN_ERRALARM & code)
+            {
+                frame.error_class |= QCanBusFrame::ControllerError;
+                frame.payload[1] |= !passive ? crtl_rx_warning | crtl_tx_warning : rec >= tec ? crtl_rx_warning : crtl_tx_warning;
+            }
+            if(passive)
+            {
+                frame.error_class |= QCanBusFrame::ControllerError;
+                frame.payload[1] |= rec >= tec ? crtl_rx_passive : crtl_tx_passive;
+            }
+            if(ZCAN_ERROR_CAN_LOSE & code)
+            {
+                frame.error_class |= QCanBusFrame::LostArbitrationError;
+                frame.payload[0] = info.arLost_ErrData & prot_loc_mask;
+            }
+            if(ZCAN_ERROR_CAN_BUSERR & code)
+            {
+                frame.error_class |= QCanBusFrame::ProtocolViolationError | QCanBusFrame::BusError;
+                if(passive)
+                {
+                    frame.payload[2] = ecc_types[ecc >> 6] | ((ecc & 0x20) ? 0 : prot_tx);
+                    frame.payload[3] = ecc & prot_loc_mask;
+                }
+            }
+            if(ZCAN_ERROR_CAN_BUSOFF & code)
+            {
+                frame.error_class |= QCanBusFrame::BusOffError;
+            }
+            return frame;
+        }
+
+        struct Description
+        {
+            quint8 bit;
+            const char* text;
+        };
+
+        constexpr Description classes[]{
+            {0, "transmission timeout"},
+            {1, "lost arbitration"},
+            {2, "controller problem"},
+            {3, "protocol violation"},
+            {4, "transceiver problem"},
+            {5, "missing acknowledgment"},
+            {6, "bus off"},
+            {7, "bus error"},
+            {8, "controller restarted"},
+            {9, "unknown error"},
+        };
+
+        constexpr Description controller_problems[]{
+            {0, "receive buffer overflow"},
+            {1, "transmit buffer overflow"},
+            {2, "receive error warning"},
+            {3, "transmit error warning"},
+            {4, "receive error passive"},
+            {5, "transmit error passive"},
+            {6, "back to error active"},
+        };
+
+        constexpr Description protocol_violations[]{
+            {0, "bit error"},
+            {1, "form error"},
+            {2, "stuff error"},
+            {3, "unable to send dominant bit"},
+            {4, "unable to send recessive bit"},
+            {5, "bus overload"},
+            {6, "active error announcement"},
+            {7, "error while transmitting"},
+        };
+
+        // indexed by payload[3]
+        constexpr const char* protocol_locations[prot_loc_mask + 1]{
+            nullptr, nullptr, "ID bits 28-21", "start of frame",
+            "substitute RTR", "identifier extension", "ID bits 20-18", "ID bits 17-13",
+            "CRC sequence", "reserved bit 0", "data section", "data length code",
+            "RTR bit", "reserved bit 1", "ID bits 4-0", "ID bits 12-5",
+            nullptr, nullptr, "intermission", nullptr,
+            nullptr, nullptr, nullptr, nullptr,
+            "CRC delimiter", "ACK slot", "end of frame", "ACK delimiter",
+            nullptr, nullptr, nullptr, nullptr,
+        };
+
+        // appends ": first, second" for the bits of a payload byte
+        template<std::size_t N>
+        void describe(QString& text, const Description (&table)[N], unsigned int bits)
+        {
+            auto separator{QLatin1String{": "}};
+            for(const auto& description: table)
+            {
+                if(bits & (1U << description.bit))
+                {
+                    text.append(separator);
+                    text.append(QLatin1String{description.text});
+                    separator = QLatin1String{", "};
+                }
+            }
+        }
+
+        QString interpret(const QCanBusFrame& frame)
+        {
+            if(QCanBusFrame::ErrorFrame != frame.frameType())
+            {
+                return QString();
+            }
+
+            QString text{};
+            text.reserve(128);
+            const auto error_class{static_cast<unsigned int>(int(frame.error()))};
+            const auto payload{frame.payload()};
+            auto byte{[&payload](int index) {
+                return index < payload.size() ? static_cast<quint8>(payload[index]) : quint8{0};
+            }};
+
+            for(const auto& description: classes)
+            {
+                const auto bit{1U << description.bit};
+                if(!(error_class & bit))
+                {
+                    continue;
+                }
+                if(!text.isEmpty())
+                {
+                    text.append(QLatin1String{"; "});
+                }
+                text.append(QLatin1String{description.text});
+                switch(bit)
+                {
+                    case QCanBusFrame::LostArbitrationError:
+                        if(byte(0))
+                        {
+                            text.append(QString{" at bit %1"}.arg(byte(0)));
+                        }
+                        break;
+                    case QCanBusFrame::ControllerError: describe(text, controller_problems, byte(1)); break;
+                    case QCanBusFrame::ProtocolViolationError:
+                    {
+                        describe(text, protocol_violations, byte(2));
+                        if(const auto location{protocol_locations[byte(3) & prot_loc_mask]})
+                        {
+                            text.append(QLatin1String{" in "});
+                            text.append(QLatin1String{location});
+                        }
+                        break;
+                    }
+                    default: break;
+                }
+            }
+            if(text.isEmpty())
+            {
+                text = QLatin1String{"unknown error"};
+            }
+            if(byte(6) || byte(7))
+            {
+                text.append(QString{" (TEC %1, REC %2)"}.arg(byte(6)).arg(byte(7)));
+            }
+            return text;
+        }
+    } //namespace error
+
+    void to_frame(const error::Frame& error_frame, quint64 timestamp, QCanBusFrame& frame)
+    {
+        frame.setFrameType(QCanBusFrame::ErrorFrame);
+        frame.setError(error_frame.error_class);
+        frame.setExtendedFrameFormat(false);
+        frame.setFlexibleDataRateFormat(false);
+        frame.setBitrateSwitch(false);
+        frame.setPayload(QByteArray(reinterpret_cast<const char*>(error_frame.payload), error::payload_size));
+        frame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(timestamp));
+    }
+
+    void to_frame(const ZCANErrorData& data, QCanBusFrame& frame)
+    {
+        to_frame(error::from(data), data.timeStamp, frame);
+    }
+} //namespace zlg
+
+QT_END_NAMESPACE
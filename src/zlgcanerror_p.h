@@ -0,0 +1,82 @@
+#ifndef ZLGCANERROR_P_H
+#define ZLGCANERROR_P_H
+
+#include <QCanBusFrame>
+#include <QString>
+#include <QtGlobal>
+#include <zlgcan/canframe.h>
+#include <zlgcan/zlgcan.h>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    /*!
+     * SocketCAN error frame layout (linux/can/error.h): the error class is carried
+     * in the frame id, details in the 8 byte payload.
+     */
+    namespace error
+    {
+        constexpr int payload_size{8};
+
+        // payload[1], controller problems
+        constexpr quint8 crtl_rx_overflow{0x01};
+        constexpr quint8 crtl_tx_overflow{0x02};
+        constexpr quint8 crtl_rx_warning{0x04};
+        constexpr quint8 crtl_tx_warning{0x08};
+        constexpr quint8 crtl_rx_passive{0x10};
+        constexpr quint8 crtl_tx_passive{0x20};
+        constexpr quint8 crtl_active{0x40};
+
+        // payload[2], protocol violation types
+        constexpr quint8 prot_bit{0x01};
+        constexpr quint8 prot_form{0x02};
+        constexpr quint8 prot_stuff{0x04};
+        constexpr quint8 prot_bit0{0x08};
+        constexpr quint8 prot_bit1{0x10};
+        constexpr quint8 prot_overload{0x20};
+        constexpr quint8 prot_active{0x40};
+        constexpr quint8 prot_tx{0x80};
+
+        // payload[3], protocol violation locations
+        constexpr quint8 prot_loc_crc_seq{0x08};
+        constexpr quint8 prot_loc_ack{0x19};
+        constexpr quint8 prot_loc_mask{0x1F};
+
+        // adapters without error records are asked for ZCAN_CHANNEL_ERR_INFO at most this often, in us
+        constexpr qint64 poll_interval{100000};
+
+        struct Frame
+        {
+            QCanBusFrame::FrameErrors error_class{QCanBusFrame::NoError};
+            quint8 payload[payload_size]{};
+        };
+
+        Frame from(const ZCANErrorData& data);
+        Frame from(const ZCAN_CHANNEL_ERR_INFO& info);
+        QString interpret(const QCanBusFrame& frame);
+
+        // false for error records of a class ErrorFilterKey masks out, checked before any frame is built
+        inline bool pass(const ZCAN_Receive_Data& data, QCanBusFrame::FrameErrors filter)
+        {
+            return !IS_ERR(data.frame.can_id) || 0 != (GET_ID(data.frame.can_id) & int(filter));
+        }
+
+        inline bool pass(const ZCAN_ReceiveFD_Data& data, QCanBusFrame::FrameErrors filter)
+        {
+            return !IS_ERR(data.frame.can_id) || 0 != (GET_ID(data.frame.can_id) & int(filter));
+        }
+
+        inline bool pass(const ZCANDataObj& data, QCanBusFrame::FrameErrors filter)
+        {
+            return ZCAN_DT_ZCAN_ERROR_DATA != data.dataType || 0 != int(from(data.data.zcanErrData).error_class & filter);
+        }
+    } //namespace error
+
+    void to_frame(const error::Frame& error_frame, quint64 timestamp, QCanBusFrame& frame);
+    void to_frame(const ZCANErrorData& data, QCanBusFrame& frame);
+} //namespace zlg
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANERROR_P_H
@@ -0,0 +1,339 @@
+#include "zlgcanfilter_p.h"
+
+#include <zlgcan/canframe.h>
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <limits>
+#include <set>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    bool matches_all(const QCanBusDevice::Filter& filter)
+    {
+        return !filter.frameIdMask && QCanBusFrame::InvalidFrame == filter.type && QCanBusDevice::Filter::MatchBaseAndExtendedFormat == (filter.format & QCanBusDevice::Filter::MatchBaseAndExtendedFormat);
+    }
+
+    bool filter_matches(const QCanBusDevice::Filter& filter, quint32 id)
+    {
+        return (id & filter.frameIdMask) == (filter.frameId & filter.frameIdMask);
+    }
+
+    // identifiers of one format a filter lets through, split on the free bits above the lowest masked bit; false if only covered
+    bool append_ranges(const QCanBusDevice::Filter& filter, bool extended, QVector<FilterRange>& ranges)
+    {
+        const auto id_mask{extended ? CAN_EFF_MASK : CAN_SFF_MASK};
+        const auto mask{filter.frameIdMask & id_mask};
+        const auto base{filter.frameId & mask};
+        const auto free{~mask & id_mask};
+        const auto block{(quint32{1} << std::countr_one(free)) - 1};
+        const auto split{free & ~block};
+        if(std::popcount(split) > FrameFilter::max_split_bits)
+        {
+            ranges.append({base, base | free, extended});
+            return false;
+        }
+        auto bits{quint32{0}};
+        do
+        {
+            ranges.append({base | bits, base | bits | block, extended});
+            bits = (bits - split) & split;
+        } while(bits);
+        return true;
+    }
+
+    void FrameFilter::set(const QList<QCanBusDevice::Filter>& filters)
+    {
+        _filters = filters;
+        _enabled = !filters.isEmpty() && std::none_of(filters.cbegin(), filters.cend(), matches_all);
+        reset_statistics();
+        if(_enabled)
+        {
+            compile(_data, QCanBusFrame::DataFrame);
+            compile(_remote, QCanBusFrame::RemoteRequestFrame);
+        }
+    }
+
+    bool FrameFilter::enabled() const
+    {
+        return _enabled;
+    }
+
+    QVector<FilterRange> FrameFilter::ranges(int limit) const
+    {
+        QVector<FilterRange> ranges{};
+        if(!_enabled)
+        {
+            return ranges;
+        }
+        for(const auto& filter: _filters)
+        {
+            if(filter.format & QCanBusDevice::Filter::MatchBaseFormat)
+            {
+                append_ranges(filter, false, ranges);
+            }
+            if(filter.format & QCanBusDevice::Filter::MatchExtendedFormat)
+            {
+                append_ranges(filter, true, ranges);
+            }
+        }
+
+        std::sort(ranges.begin(), ranges.end(), [](const FilterRange& left, const FilterRange& right) {
+            return left.extended != right.extended ? right.extended : left.start < right.start;
+        });
+        auto merged{0};
+        for(auto i{1}; i < ranges.size(); ++i)
+        {
+            auto& last{ranges[merged]};
+            if(last.extended == ranges[i].extended && ranges[i].start <= last.end + 1)
+            {
+                last.end = qMax(last.end, ranges[i].end);
+            }
+            else
+            {
+                ranges[++merged] = ranges[i];
+            }
+        }
+        ranges.resize(ranges.isEmpty() ? 0 : merged + 1);
+
+        // over the adapter's limit, the two neighbours with the smallest gap are joined, which lets through the fewest extra identifiers
+        while(ranges.size() > limit)
+        {
+            auto best{-1};
+            auto best_gap{std::numeric_limits<quint32>::max()};
+            for(auto i{0}; i + 1 < ranges.size(); ++i)
+            {
+                const auto gap{ranges[i + 1].start - ranges[i].end};
+                if(ranges[i].extended == ranges[i + 1].extended && gap < best_gap)
+                {
+                    best = i;
+                    best_gap = gap;
+                }
+            }
+            if(best < 0)
+            {
+                return {};
+            }
+            ranges[best].end = ranges[best + 1].end;
+            ranges.remove(best + 1);
+        }
+        return ranges;
+    }
+
+    bool FrameFilter::acceptance(UINT& code, UINT& mask) const
+    {
+        if(!_enabled)
+        {
+            return false;
+        }
+        const auto format{_filters.front().format & QCanBusDevice::Filter::MatchBaseAndExtendedFormat};
+        if(QCanBusDevice::Filter::MatchBaseAndExtendedFormat == format)
+        {
+            return false;
+        }
+
+        // bits every filter compares and agrees on, left aligned as the SJA1000 single filter expects them
+        const auto extended{QCanBusDevice::Filter::MatchExtendedFormat == format};
+        const auto id_mask{extended ? CAN_EFF_MASK : CAN_SFF_MASK};
+        const auto shift{extended ? 3 : 21};
+        const auto reference{_filters.front().frameId & id_mask};
+        auto care{id_mask};
+        for(const auto& filter: _filters)
+        {
+            if(format != (filter.format & QCanBusDevice::Filter::MatchBaseAndExtendedFormat))
+            {
+                return false;
+            }
+            care &= filter.frameIdMask & ~(filter.frameId ^ reference);
+        }
+        if(!care)
+        {
+            return false;
+        }
+        code = (reference & care) << shift;
+        mask = ~(care << shift);
+        return true;
+    }
+
+    void FrameFilter::compile(Index& index, QCanBusFrame::FrameType type) const
+    {
+        index = Index{};
+        index.standard_owner.fill(no_filter);
+        QVector<FilterRange> split{};
+        QVector<IndexedRange> ranges{};
+        const auto count{qMin(static_cast<int>(_filters.size()), static_cast<int>(no_filter))};
+        for(auto i{0}; i < count; ++i)
+        {
+            const auto& filter{_filters[i]};
+            if(QCanBusFrame::InvalidFrame != filter.type && type != filter.type)
+            {
+                continue;
+            }
+            const auto filter_index{static_cast<quint16>(i)};
+            if(filter.format & QCanBusDevice::Filter::MatchBaseFormat)
+            {
+                for(auto id{quint32{0}}; id <= CAN_SFF_MASK; ++id)
+                {
+                    if(!index.standard[id] && filter_matches(filter, id))
+                    {
+                        index.standard.set(id);
+                        index.standard_owner[id] = filter_index;
+                    }
+                }
+            }
+            if((filter.format & QCanBusDevice::Filter::MatchExtendedFormat) && !(filter.frameId & filter.frameIdMask & ~CAN_EFF_MASK))
+            {
+                split.clear();
+                if(!append_ranges(filter, true, split))
+                {
+                    index.residual.append(filter_index);
+                    continue;
+                }
+                for(const auto& range: split)
+                {
+                    ranges.append({range.start, range.end, filter_index});
+                }
+            }
+        }
+
+        // overlapping ranges are cut at every boundary and each piece goes to the first filter covering it
+        struct Boundary
+        {
+            quint32 at;
+            bool open;
+            quint16 filter;
+        };
+        QVector<Boundary> boundaries{};
+        boundaries.reserve(ranges.size() * 2);
+        for(const auto& range: ranges)
+        {
+            boundaries.append({range.start, true, range.filter});
+            boundaries.append({range.end + 1, false, range.filter});
+        }
+        std::sort(boundaries.begin(), boundaries.end(), [](const Boundary& left, const Boundary& right) {
+            return left.at < right.at;
+        });
+        std::multiset<quint16> active{};
+        for(auto i{0}; i < boundaries.size();)
+        {
+            const auto at{boundaries[i].at};
+            for(; i < boundaries.size() && boundaries[i].at == at; ++i)
+            {
+                if(boundaries[i].open)
+                {
+                    active.insert(boundaries[i].filter);
+                }
+                else
+                {
+                    active.erase(active.find(boundaries[i].filter));
+                }
+            }
+            if(active.empty() || i == boundaries.size())
+            {
+                continue;
+            }
+            const auto owner{*active.cbegin()};
+            const auto end{boundaries[i].at - 1};
+            auto& extended{index.extended};
+            if(!extended.isEmpty() && extended.back().filter == owner && extended.back().end + 1 == at)
+            {
+                extended.back().end = end;
+            }
+            else
+            {
+                extended.append({at, end, owner});
+            }
+        }
+    }
+
+    quint16 FrameFilter::find(const Index& index, quint32 id, bool extended) const
+    {
+        if(!extended)
+        {
+            return id <= CAN_SFF_MASK && index.standard[id] ? index.standard_owner[id] : no_filter;
+        }
+
+        auto owner{no_filter};
+        const auto& ranges{index.extended};
+        const auto next{std::upper_bound(ranges.cbegin(), ranges.cend(), id, [](quint32 id, const IndexedRange& range) {
+            return id < range.start;
+        })};
+        if(next != ranges.cbegin() && id <= std::prev(next)->end)
+        {
+            owner = std::prev(next)->filter;
+        }
+        for(const auto filter: index.residual)
+        {
+            if(filter >= owner)
+            {
+                break;
+            }
+            if(filter_matches(_filters[filter], id))
+            {
+                return filter;
+            }
+        }
+        return owner;
+    }
+
+    bool FrameFilter::accept(quint32 id, bool extended, QCanBusFrame::FrameType type)
+    {
+        if(!_enabled || QCanBusFrame::ErrorFrame == type)
+        {
+            return true;
+        }
+        const auto filter{find(QCanBusFrame::RemoteRequestFrame == type ? _remote : _data, id, extended)};
+        if(no_filter == filter)
+        {
+            ++_dropped;
+            return false;
+        }
+        ++_hits[filter];
+        return true;
+    }
+
+    bool FrameFilter::accept(const ZCAN_Receive_Data& data)
+    {
+        const auto can_id{data.frame.can_id};
+        return accept(GET_ID(can_id), IS_EFF(can_id), IS_ERR(can_id) ? QCanBusFrame::ErrorFrame : IS_RTR(can_id) ? QCanBusFrame::RemoteRequestFrame : QCanBusFrame::DataFrame);
+    }
+
+    bool FrameFilter::accept(const ZCAN_ReceiveFD_Data& data)
+    {
+        const auto can_id{data.frame.can_id};
+        return accept(GET_ID(can_id), IS_EFF(can_id), IS_ERR(can_id) ? QCanBusFrame::ErrorFrame : QCanBusFrame::DataFrame);
+    }
+
+    bool FrameFilter::accept(const ZCANDataObj& data)
+    {
+        if(ZCAN_DT_ZCAN_CAN_CANFD_DATA != data.dataType)
+        {
+            return true;
+        }
+        const auto& can_data{data.data.zcanCANFDData};
+        const auto can_id{can_data.frame.can_id};
+        const auto fd{1 == can_data.flag.unionVal.frameType};
+        return accept(GET_ID(can_id), IS_EFF(can_id), IS_ERR(can_id) ? QCanBusFrame::ErrorFrame : !fd && IS_RTR(can_id) ? QCanBusFrame::RemoteRequestFrame : QCanBusFrame::DataFrame);
+    }
+
+    const QVector<quint64>& FrameFilter::hits() const
+    {
+        return _hits;
+    }
+
+    quint64 FrameFilter::dropped() const
+    {
+        return _dropped;
+    }
+
+    void FrameFilter::reset_statistics()
+    {
+        _hits.fill(0, _filters.size());
+        _dropped = 0;
+    }
+} //namespace zlg
+
+QT_END_NAMESPACE
@@ -0,0 +1,93 @@
+#ifndef ZLGCANFILTER_P_H
+#define ZLGCANFILTER_P_H
+
+#include "zlgcan/zlgcan.h"
+
+#include <QCanBusDevice>
+#include <QList>
+#include <QVector>
+
+#include <array>
+#include <bitset>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    // inclusive range of identifiers of one format
+    struct FilterRange
+    {
+        quint32 start{0};
+        quint32 end{0};
+        bool extended{false};
+    };
+
+    /*!
+     * RawFilterKey filters split into what the adapter can do and what is left
+     * for the host. The hardware only sees identifiers, so it gets a covering set
+     * of ranges or a single acceptance code and mask, which may let through more
+     * than asked for; accept() then applies the exact QCanBusDevice::Filter
+     * semantics to every received record. Error records always pass, they are
+     * governed by ErrorFilterKey.
+     *
+     * set() compiles the filters into one index per frame type: a bitmap over all
+     * standard identifiers, and disjoint sorted ranges for extended identifiers,
+     * so a record costs one bit test or one binary search however many filters
+     * there are. Only extended filters too wide to split are checked one by one.
+     * A frame passed is counted for the first filter matching it, as Qt would.
+     */
+    class FrameFilter
+    {
+    public:
+        // a filter with more free identifier bits above its lowest masked bit is covered by one range instead of 2^n
+        static constexpr int max_split_bits{6};
+
+        void set(const QList<QCanBusDevice::Filter>& filters);
+        bool enabled() const;
+
+        QVector<FilterRange> ranges(int limit) const;
+        bool acceptance(UINT& code, UINT& mask) const;
+
+        bool accept(quint32 id, bool extended, QCanBusFrame::FrameType type);
+        bool accept(const ZCAN_Receive_Data& data);
+        bool accept(const ZCAN_ReceiveFD_Data& data);
+        bool accept(const ZCANDataObj& data);
+
+        const QVector<quint64>& hits() const;
+        quint64 dropped() const;
+        void reset_statistics();
+
+    private:
+        static constexpr quint16 no_filter{0xFFFF};
+
+        struct IndexedRange
+        {
+            quint32 start{0};
+            quint32 end{0};
+            quint16 filter{no_filter};
+        };
+
+        // one per frame type, the owner table is only read for identifiers the bitmap lets through
+        struct Index
+        {
+            std::bitset<2048> standard{};
+            std::array<quint16, 2048> standard_owner{};
+            QVector<IndexedRange> extended{};
+            QVector<quint16> residual{};
+        };
+
+        void compile(Index& index, QCanBusFrame::FrameType type) const;
+        quint16 find(const Index& index, quint32 id, bool extended) const;
+
+        QList<QCanBusDevice::Filter> _filters{};
+        bool _enabled{false};
+        Index _data{};
+        Index _remote{};
+        QVector<quint64> _hits{};
+        quint64 _dropped{0};
+    };
+} //namespace zlg
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANFILTER_P_H
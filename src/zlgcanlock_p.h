@@ -0,0 +1,99 @@
+#ifndef ZLGCANLOCK_P_H
+#define ZLGCANLOCK_P_H
+
+#include "zlgcanbackend.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+
+#include <atomic>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    /*!
+     * Mutex guarding one path of vendor calls on a channel. The DLL keeps separate
+     * receive and transmit queues per channel, so the paths are only serialized
+     * against themselves:
+     *
+     * - receive: ZCAN_Receive, ZCAN_ReceiveFD, ZCAN_ReceiveData. ZCAN_GetReceiveNum
+     *   only reads a counter and needs no lock. The receive thread is the only
+     *   reader while it runs, so it takes no lock either; ZCAN_ReceiveData is only
+     *   called by the device-wide receive engine, which owns it for all channels.
+     * - transmit: ZCAN_Transmit, ZCAN_TransmitFD, ZCAN_TransmitData, so batches of
+     *   the timer path, the transmit thread, schedules and cyclic frames never interleave.
+     * - control: ZCAN_ReadChannelErrInfo, ZCAN_SetValue and ZCAN_GetValue.
+     *
+     * Opening, resetting and closing a channel hold all three, in that order.
+     * ZCAN_TransmitData goes through the device handle rather than the channel,
+     * so it also takes the adapter-wide mutex of DeviceRegistry::transmit_mutex(),
+     * always last and only around the call itself.
+     * An uncontended lock() costs one tryLock(); only waits are timed.
+     */
+    class ChannelMutex
+    {
+        ChannelMutex(const ChannelMutex&) = delete;
+        ChannelMutex& operator=(const ChannelMutex&) = delete;
+
+    public:
+        ChannelMutex() = default;
+
+        void lock()
+        {
+            if(!_mutex.tryLock())
+            {
+                QElapsedTimer timer{};
+                timer.start();
+                _mutex.lock();
+                _contentions.fetch_add(1, std::memory_order_relaxed);
+                _wait_time.fetch_add(static_cast<quint64>(timer.nsecsElapsed()), std::memory_order_relaxed);
+            }
+            _acquisitions.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void unlock()
+        {
+            _mutex.unlock();
+        }
+
+        ZlgCanBackend::LockStatistics statistics() const
+        {
+            ZlgCanBackend::LockStatistics statistics{};
+            statistics.acquisitions = _acquisitions.load(std::memory_order_relaxed);
+            statistics.contentions = _contentions.load(std::memory_order_relaxed);
+            statistics.waitTime = _wait_time.load(std::memory_order_relaxed);
+            return statistics;
+        }
+
+    private:
+        QMutex _mutex{};
+        std::atomic<quint64> _acquisitions{0};
+        std::atomic<quint64> _contentions{0};
+        std::atomic<quint64> _wait_time{0};
+    };
+
+    class ChannelLocker
+    {
+        ChannelLocker(const ChannelLocker&) = delete;
+        ChannelLocker& operator=(const ChannelLocker&) = delete;
+
+    public:
+        explicit ChannelLocker(ChannelMutex& mutex): _mutex(mutex)
+        {
+            _mutex.lock();
+        }
+
+        ~ChannelLocker()
+        {
+            _mutex.unlock();
+        }
+
+    private:
+        ChannelMutex& _mutex;
+    };
+} //namespace zlg
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANLOCK_P_H
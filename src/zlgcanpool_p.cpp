@@ -0,0 +1,95 @@
+#include "zlgcanpool_p.h"
+
+#include <zlgcan/canframe.h>
+
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    void PayloadPool::reset(int size)
+    {
+        _size = size < 0 ? 0 : size;
+        _can = {};
+        _canfd = {};
+        _can.buffers.reserve(_size);
+        _canfd.buffers.reserve(_size);
+    }
+
+    void PayloadPool::tick(qint64 now)
+    {
+        if(_window_start < 0)
+        {
+            _window_start = now;
+            _window_allocations = _allocations;
+        }
+        else if(now - _window_start >= 1000000)
+        {
+            _allocations_per_second = (_allocations - _window_allocations) * 1000000 / (now - _window_start);
+            _window_start = now;
+            _window_allocations = _allocations;
+        }
+    }
+
+    QByteArray PayloadPool::acquire(const void* data, int length)
+    {
+        if(length <= 0)
+        {
+            return QByteArray();
+        }
+        if(length <= CAN_MAX_DLEN)
+        {
+            return acquire(_can, CAN_MAX_DLEN, data, length);
+        }
+        return acquire(_canfd, CANFD_MAX_DLEN, data, length);
+    }
+
+    QByteArray PayloadPool::acquire(Slots& bucket, int capacity, const void* data, int length)
+    {
+        // consumers usually release frames in arrival order, so the slot after the last one handed out is normally free
+        constexpr auto scan_limit{8};
+        const auto count{bucket.buffers.size()};
+        for(auto i{0}; i < scan_limit && i < count; ++i)
+        {
+            auto& buffer{bucket.buffers[(bucket.cursor + i) % count]};
+            if(buffer.isDetached())
+            {
+                buffer.resize(length);
+                ::memcpy(buffer.data(), data, length);
+                bucket.cursor = (bucket.cursor + i + 1) % count;
+                ++_reuses;
+                return buffer;
+            }
+        }
+
+        ++_allocations;
+        if(count < _size)
+        {
+            QByteArray buffer{};
+            buffer.reserve(capacity);
+            buffer.resize(length);
+            ::memcpy(buffer.data(), data, length);
+            bucket.buffers.append(buffer);
+            return buffer;
+        }
+        return QByteArray(static_cast<const char*>(data), length);
+    }
+
+    quint64 PayloadPool::allocations() const
+    {
+        return _allocations;
+    }
+
+    quint64 PayloadPool::reuses() const
+    {
+        return _reuses;
+    }
+
+    quint64 PayloadPool::allocations_per_second() const
+    {
+        return _allocations_per_second;
+    }
+} //namespace zlg
+
+QT_END_NAMESPACE
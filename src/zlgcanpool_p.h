@@ -0,0 +1,52 @@
+#ifndef ZLGCANPOOL_P_H
+#define ZLGCANPOOL_P_H
+
+#include <QByteArray>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    /*!
+     * Recycles the implicitly shared payload buffers handed to QCanBusFrame.
+     * A buffer is reused once every frame referring to it has been released,
+     * which QByteArray reports as detached. Not thread-safe; owned by the
+     * thread that converts received records.
+     */
+    class PayloadPool
+    {
+    public:
+        void reset(int size);
+        void tick(qint64 now);
+
+        QByteArray acquire(const void* data, int length);
+
+        quint64 allocations() const;
+        quint64 reuses() const;
+        quint64 allocations_per_second() const;
+
+    private:
+        struct Slots
+        {
+            QVector<QByteArray> buffers{};
+            int cursor{0};
+        };
+
+        QByteArray acquire(Slots& bucket, int capacity, const void* data, int length);
+
+        int _size{0};
+        Slots _can{};
+        Slots _canfd{};
+
+        quint64 _allocations{0};
+        quint64 _reuses{0};
+        quint64 _window_allocations{0};
+        quint64 _allocations_per_second{0};
+        qint64 _window_start{-1};
+    };
+} //namespace zlg
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANPOOL_P_H
@@ -0,0 +1,117 @@
+#include "zlgcanprobe_p.h"
+
+#include "zlgcanbackend_p.h"
+#include "zlgcandevices_p.h"
+#include "zlgcanregistry_p.h"
+
+#include <QByteArray>
+#include <QDeadlineTimer>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    QString from_device_string(const UCHAR* data, std::size_t size)
+    {
+        const auto text{reinterpret_cast<const char*>(data)};
+        return QString::fromLatin1(text, static_cast<int>(qstrnlen(text, static_cast<uint>(size)))).trimmed();
+    }
+
+    DeviceProbe::DeviceProbe()
+    {
+        // statics are destroyed in reverse order of construction, so these outlive the probe threads
+        Loader::instance();
+        DeviceRegistry::instance();
+        get_devices();
+    }
+
+    DeviceProbe::~DeviceProbe()
+    {
+        for(auto& [type, state]: _types)
+        {
+            if(state.thread.joinable())
+            {
+                state.thread.join();
+            }
+        }
+    }
+
+    DeviceProbe* DeviceProbe::instance()
+    {
+        static DeviceProbe instance{};
+        return &instance;
+    }
+
+    QVector<ProbedDevice> DeviceProbe::devices(int timeout)
+    {
+        const QMutexLocker locker{&_mutex};
+
+        if(_probed.isValid() && _probed.elapsed() < cache_time)
+        {
+            return _devices;
+        }
+
+        for(const auto* device: get_devices())
+        {
+            auto& state{_types[device->type]};
+            if(state.running)
+            {
+                continue;
+            }
+            // a finished probe only has to be reaped before its type is probed again
+            if(state.thread.joinable())
+            {
+                state.thread.join();
+            }
+            state.running = true;
+            ++_running;
+            state.thread = std::thread([this, type = device->type]() {
+                probe(type);
+            });
+        }
+
+        const QDeadlineTimer deadline{timeout};
+        while(_running && _finished.wait(&_mutex, deadline))
+        {
+        }
+
+        _devices.clear();
+        for(const auto* device: get_devices())
+        {
+            _devices.append(_types[device->type].found);
+        }
+        _probed.start();
+        return _devices;
+    }
+
+    void DeviceProbe::probe(unsigned int type)
+    {
+        QVector<ProbedDevice> found{};
+        const auto& device{get_device(type)};
+        for(auto index{0U}; index < max_indexes; ++index)
+        {
+            // adapters of one type are numbered from 0 without gaps
+            ZCAN_DEVICE_INFO info{};
+            if(!DeviceRegistry::instance()->device_info(type, index, info))
+            {
+                break;
+            }
+            found.append({
+                type,
+                index,
+                info.can_Num ? info.can_Num : device.channels,
+                from_device_string(info.str_Serial_Num, sizeof(info.str_Serial_Num)),
+                from_device_string(info.str_hw_Type, sizeof(info.str_hw_Type)),
+            });
+        }
+
+        const QMutexLocker locker{&_mutex};
+        auto& state{_types[type]};
+        state.found = found;
+        state.running = false;
+        --_running;
+        _finished.wakeAll();
+    }
+} //namespace zlg
+
+QT_END_NAMESPACE
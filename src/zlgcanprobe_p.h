@@ -0,0 +1,79 @@
+#ifndef ZLGCANPROBE_P_H
+#define ZLGCANPROBE_P_H
+
+#include "zlgcan/zlgcan.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <map>
+#include <thread>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    // an adapter found connected
+    struct ProbedDevice
+    {
+        unsigned int type{0};
+        unsigned int index{0};
+        unsigned int channels{0};
+        QString serial_number{};
+        QString description{};
+    };
+
+    /*!
+     * Live enumeration behind ZlgCanBackend::interfaces() when ZLGCAN_PROBE is set.
+     * Every device type of the device table is probed on a thread of its own,
+     * index after index with ZCAN_OpenDevice and ZCAN_GetDeviceInf until an index
+     * does not open, so a listing takes as long as the slowest driver rather than
+     * all of them. devices() waits at most the timeout given; a type whose probe
+     * is still running then keeps what it found last time and is not probed again
+     * until that probe returns. The result is cached for cache_time milliseconds.
+     * The probe threads are joined when the probe is destroyed at exit, before
+     * the registry and the loader they call into.
+     */
+    class DeviceProbe
+    {
+        DeviceProbe(const DeviceProbe&) = delete;
+        DeviceProbe& operator=(const DeviceProbe&) = delete;
+        DeviceProbe(DeviceProbe&&) = delete;
+        DeviceProbe& operator=(DeviceProbe&&) = delete;
+
+    public:
+        static constexpr unsigned int max_indexes{8};
+        static constexpr int cache_time{2000};
+
+        static DeviceProbe* instance();
+
+        QVector<ProbedDevice> devices(int timeout);
+
+    private:
+        DeviceProbe();
+        ~DeviceProbe();
+
+        struct TypeState
+        {
+            bool running{false};
+            std::thread thread{};
+            QVector<ProbedDevice> found{};
+        };
+
+        void probe(unsigned int type);
+
+        QMutex _mutex{};
+        QWaitCondition _finished{};
+        std::map<unsigned int, TypeState> _types{};
+        int _running{0};
+        QElapsedTimer _probed{};
+        QVector<ProbedDevice> _devices{};
+    };
+} //namespace zlg
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANPROBE_P_H
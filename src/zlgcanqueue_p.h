@@ -0,0 +1,110 @@
+#ifndef ZLGCANQUEUE_P_H
+#define ZLGCANQUEUE_P_H
+
+#include <QDeadlineTimer>
+#include <QMutex>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <cstddef>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    /*!
+     * Bounded multi-producer/single-consumer queue. push() may block up to a timeout
+     * while the queue is full, which is how producers feel back-pressure; pop() takes
+     * a whole batch at once. close() releases every waiter.
+     */
+    template<typename T>
+    class MpscQueue
+    {
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+    public:
+        MpscQueue() = default;
+
+        void reset(int capacity)
+        {
+            const QMutexLocker locker{&_mutex};
+            _buffer = QVector<T>(capacity < 1 ? 1 : capacity);
+            _head = 0;
+            _size = 0;
+            _closed = false;
+        }
+
+        bool push(const T& value, int timeout)
+        {
+            const QMutexLocker locker{&_mutex};
+            QDeadlineTimer deadline{timeout < 0 ? 0 : timeout};
+            while(!_closed && _size == _buffer.size())
+            {
+                if(timeout <= 0 || !_not_full.wait(&_mutex, deadline))
+                {
+                    return false;
+                }
+            }
+            if(_closed)
+            {
+                return false;
+            }
+
+            _buffer[(_head + _size) % _buffer.size()] = value;
+            ++_size;
+            _not_empty.wakeOne();
+            return true;
+        }
+
+        std::size_t pop(T* values, std::size_t size, int timeout)
+        {
+            const QMutexLocker locker{&_mutex};
+            if(!_closed && !_size)
+            {
+                _not_empty.wait(&_mutex, QDeadlineTimer{timeout});
+            }
+
+            auto count{std::size_t{0}};
+            while(count < size && _size)
+            {
+                values[count++] = std::move(_buffer[_head]);
+                _buffer[_head] = T{};
+                _head = (_head + 1) % _buffer.size();
+                --_size;
+            }
+            if(count)
+            {
+                _not_full.wakeAll();
+            }
+            return count;
+        }
+
+        void close()
+        {
+            const QMutexLocker locker{&_mutex};
+            _closed = true;
+            _not_empty.wakeAll();
+            _not_full.wakeAll();
+        }
+
+        int size() const
+        {
+            const QMutexLocker locker{&_mutex};
+            return _size;
+        }
+
+    private:
+        mutable QMutex _mutex{};
+        QWaitCondition _not_empty{};
+        QWaitCondition _not_full{};
+        QVector<T> _buffer{};
+        int _head{0};
+        int _size{0};
+        bool _closed{true};
+    };
+} //namespace zlg
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANQUEUE_P_H
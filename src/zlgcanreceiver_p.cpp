@@ -0,0 +1,63 @@
+#include "zlgcanreceiver_p.h"
+
+QT_BEGIN_NAMESPACE
+
+ZlgCanReceiver::ZlgCanReceiver(const zlg::Loader* dll, const Context& context, QObject* parent): QThread(parent), dll(dll), _context(context)
+{
+    // a zero wait turns the receive loop into a busy spin
+    _context.wait_time = qMax(_context.wait_time, 1);
+}
+
+ZlgCanReceiver::~ZlgCanReceiver()
+{
+    stop();
+}
+
+void ZlgCanReceiver::stop()
+{
+    requestInterruption();
+    wait();
+}
+
+void ZlgCanReceiver::acknowledge()
+{
+    _notified.store(false, std::memory_order_release);
+}
+
+void ZlgCanReceiver::run()
+{
+    ZCAN_Receive_Data data[64]{};
+    ZCAN_ReceiveFD_Data fd_data[64]{};
+    constexpr auto data_size{sizeof(data) / sizeof(data[0])};
+    constexpr auto fd_data_size{sizeof(fd_data) / sizeof(fd_data[0])};
+
+    // wait_time bounds every blocking call, so an interruption request is honoured within one wait_time
+    const auto wait_time{_context.fd_enabled ? qMin(_context.wait_time, split_wait_time) : _context.wait_time};
+    auto block_fd{false};
+    while(!isInterruptionRequested())
+    {
+        auto result{_context.counters->call(ZlgCanBackend::ReceiveFunction, [&]() {
+            return dll->ZCAN_Receive(_context.channel_handle, data, data_size, _context.fd_enabled && block_fd ? 0 : wait_time);
+        })};
+        _context.counters->receive_batch(result);
+        auto count{_context.ring->push(data, result)};
+
+        if(_context.fd_enabled)
+        {
+            auto fd_result{_context.counters->call(ZlgCanBackend::ReceiveFDFunction, [&]() {
+                return dll->ZCAN_ReceiveFD(_context.channel_handle, fd_data, fd_data_size, result || !block_fd ? 0 : wait_time);
+            })};
+            _context.counters->receive_batch(fd_result);
+            count += _context.fd_ring->push(fd_data, fd_result);
+            // an idle pass hands the blocking wait to the other queue
+            block_fd = result || fd_result ? block_fd : !block_fd;
+        }
+
+        if(count && !_notified.exchange(true, std::memory_order_acq_rel))
+        {
+            emit framesAvailable();
+        }
+    }
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,59 @@
+#ifndef ZLGCANRECEIVER_P_H
+#define ZLGCANRECEIVER_P_H
+
+#include "zlgcanbackend_p.h"
+#include "zlgcanring_p.h"
+
+#include <QThread>
+#include <atomic>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * Blocks in ZCAN_Receive/ZCAN_ReceiveFD on a dedicated thread and copies the raw
+ * records into SPSC rings. framesAvailable() is emitted once per batch that finds
+ * the consumer idle; the consumer calls acknowledge() before draining the rings.
+ * With CAN FD, the CAN and CAN FD queues cannot be waited on together, so an idle
+ * loop blocks on them in turns for at most split_wait_time ms each, which bounds
+ * how long a frame waits while the other queue is the one blocked on.
+ * Merged reception goes through ZlgCanReceiveEngine instead.
+ */
+class ZlgCanReceiver: public QThread
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(ZlgCanReceiver)
+
+public:
+    static constexpr int split_wait_time{1};
+
+    struct Context
+    {
+        CHANNEL_HANDLE channel_handle{INVALID_CHANNEL_HANDLE};
+        bool fd_enabled{false};
+        int wait_time{0};
+        zlg::SpscRing<ZCAN_Receive_Data>* ring{};
+        zlg::SpscRing<ZCAN_ReceiveFD_Data>* fd_ring{};
+        zlg::PerformanceCounters* counters{};
+    };
+
+    explicit ZlgCanReceiver(const zlg::Loader* dll, const Context& context, QObject* parent = nullptr);
+    ~ZlgCanReceiver();
+
+    void stop();
+    void acknowledge();
+
+signals:
+    void framesAvailable();
+
+protected:
+    void run() override;
+
+private:
+    const zlg::Loader* dll{};
+    Context _context{};
+    std::atomic_bool _notified{false};
+};
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANRECEIVER_P_H
@@ -0,0 +1,214 @@
+#include "zlgcanregistry_p.h"
+
+#include "zlgcanengine_p.h"
+
+#include <QDeadlineTimer>
+#include <QLoggingCategory>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_CANBUS_PLUGINS_ZLGCAN)
+
+namespace zlg
+{
+    DeviceRegistry* DeviceRegistry::instance()
+    {
+        static DeviceRegistry instance{};
+        return &instance;
+    }
+
+    DEVICE_HANDLE DeviceRegistry::acquire(unsigned int type, unsigned int index, unsigned int channel)
+    {
+        const QMutexLocker locker{&_mutex};
+
+        const auto key{qMakePair(type, index)};
+        if(!wait_probed(key))
+        {
+            qCWarning(QT_CANBUS_PLUGINS_ZLGCAN, "Cannot open device %u index %u, it is still being probed.", type, index);
+            return INVALID_DEVICE_HANDLE;
+        }
+        auto& entry{_devices[key]};
+        if(entry.channels.contains(channel))
+        {
+            return INVALID_DEVICE_HANDLE;
+        }
+        if(!entry.handle)
+        {
+            entry.handle = Loader::instance()->ZCAN_OpenDevice(type, index, 0);
+            if(!entry.handle)
+            {
+                _devices.remove(key);
+                return INVALID_DEVICE_HANDLE;
+            }
+        }
+        entry.channels.insert(channel);
+        return entry.handle;
+    }
+
+    void DeviceRegistry::release(unsigned int type, unsigned int index, unsigned int channel)
+    {
+        const QMutexLocker locker{&_mutex};
+
+        const auto key{qMakePair(type, index)};
+        if(!_devices.contains(key))
+        {
+            return;
+        }
+        auto& entry{_devices[key]};
+        entry.channels.remove(channel);
+        if(entry.channels.isEmpty())
+        {
+            delete entry.engine;
+            Loader::instance()->ZCAN_CloseDevice(entry.handle);
+            _devices.remove(key);
+        }
+    }
+
+    int DeviceRegistry::channels(unsigned int type, unsigned int index) const
+    {
+        const QMutexLocker locker{&_mutex};
+
+        const auto key{qMakePair(type, index)};
+        return _devices.contains(key) ? _devices[key].channels.size() : 0;
+    }
+
+    ChannelMutex* DeviceRegistry::transmit_mutex(unsigned int type, unsigned int index) const
+    {
+        const QMutexLocker locker{&_mutex};
+
+        const auto key{qMakePair(type, index)};
+        return _devices.contains(key) ? _devices[key].transmit_mutex.data() : nullptr;
+    }
+
+    bool DeviceRegistry::merge_receive(unsigned int type, unsigned int index, bool requested)
+    {
+        const QMutexLocker locker{&_mutex};
+
+        const auto key{qMakePair(type, index)};
+        if(!_devices.contains(key))
+        {
+            return false;
+        }
+        auto& entry{_devices[key]};
+        if(entry.merge_receive < 0)
+        {
+            entry.merge_receive = requested && STATUS_OK == Loader::instance()->ZCAN_SetValue(entry.handle, "0/set_device_recv_merge", "1") ? 1 : 0;
+            if(requested && !entry.merge_receive)
+            {
+                qCWarning(QT_CANBUS_PLUGINS_ZLGCAN, "Cannot enable merged reception, falling back to ZCAN_Receive/ZCAN_ReceiveFD.");
+            }
+        }
+        else if(requested != (1 == entry.merge_receive))
+        {
+            qCWarning(QT_CANBUS_PLUGINS_ZLGCAN, "Device %u index %u already receives %s, following it.", type, index, entry.merge_receive ? "merged" : "per channel");
+        }
+        return 1 == entry.merge_receive;
+    }
+
+    bool DeviceRegistry::set_value(unsigned int type, unsigned int index, const QByteArray& path, const QByteArray& value)
+    {
+        const QMutexLocker locker{&_mutex};
+
+        const auto key{qMakePair(type, index)};
+        if(!_devices.contains(key))
+        {
+            return false;
+        }
+        auto& entry{_devices[key]};
+        const auto written{entry.values.constFind(path)};
+        if(written != entry.values.cend() && *written == value)
+        {
+            return true;
+        }
+        // a failed write leaves the adapter's value unknown
+        entry.values.remove(path);
+        if(STATUS_OK != Loader::instance()->ZCAN_SetValue(entry.handle, path, value))
+        {
+            return false;
+        }
+        entry.values.insert(path, value);
+        return true;
+    }
+
+    bool DeviceRegistry::device_info(unsigned int type, unsigned int index, ZCAN_DEVICE_INFO& info)
+    {
+        QMutexLocker locker{&_mutex};
+
+        const auto key{qMakePair(type, index)};
+        if(!wait_probed(key))
+        {
+            return false;
+        }
+        if(_devices.contains(key))
+        {
+            return STATUS_OK == Loader::instance()->ZCAN_GetDeviceInf(_devices[key].handle, &info);
+        }
+
+        // opening an adapter can take long, other adapters are acquired and probed meanwhile
+        _probing.insert(key);
+        locker.unlock();
+        auto found{false};
+        const auto handle{Loader::instance()->ZCAN_OpenDevice(type, index, 0)};
+        if(handle)
+        {
+            found = STATUS_OK == Loader::instance()->ZCAN_GetDeviceInf(handle, &info);
+            Loader::instance()->ZCAN_CloseDevice(handle);
+        }
+        locker.relock();
+        _probing.remove(key);
+        _probed.wakeAll();
+        return found;
+    }
+
+    bool DeviceRegistry::wait_probed(const QPair<unsigned int, unsigned int>& key)
+    {
+        const QDeadlineTimer deadline{probe_wait};
+        while(_probing.contains(key))
+        {
+            if(!_probed.wait(&_mutex, deadline))
+            {
+                return !_probing.contains(key);
+            }
+        }
+        return true;
+    }
+
+    void DeviceRegistry::subscribe(unsigned int type, unsigned int index, unsigned int channel, ReceiveSubscriber* subscriber, int wait_time)
+    {
+        const QMutexLocker locker{&_mutex};
+
+        const auto key{qMakePair(type, index)};
+        if(!_devices.contains(key))
+        {
+            return;
+        }
+        auto& entry{_devices[key]};
+        if(entry.engine)
+        {
+            entry.engine->subscribe(channel, subscriber);
+            return;
+        }
+        entry.engine = new ZlgCanReceiveEngine(Loader::instance(), entry.handle, wait_time);
+        entry.engine->subscribe(channel, subscriber);
+        entry.engine->start(QThread::TimeCriticalPriority);
+    }
+
+    void DeviceRegistry::unsubscribe(unsigned int type, unsigned int index, unsigned int channel)
+    {
+        const QMutexLocker locker{&_mutex};
+
+        const auto key{qMakePair(type, index)};
+        if(!_devices.contains(key) || !_devices[key].engine)
+        {
+            return;
+        }
+        auto& entry{_devices[key]};
+        if(!entry.engine->unsubscribe(channel))
+        {
+            delete entry.engine;
+            entry.engine = nullptr;
+        }
+    }
+} //namespace zlg
+
+QT_END_NAMESPACE
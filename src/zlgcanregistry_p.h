@@ -0,0 +1,85 @@
+#ifndef ZLGCANREGISTRY_P_H
+#define ZLGCANREGISTRY_P_H
+
+#include "zlgcanbackend_p.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QSet>
+#include <QSharedPointer>
+#include <QWaitCondition>
+
+QT_BEGIN_NAMESPACE
+
+class ZlgCanReceiveEngine;
+
+namespace zlg
+{
+    /*!
+     * Owns the DEVICE_HANDLE of every open adapter, keyed by device type and index.
+     * The first channel opened on an adapter opens the device, the last one closed
+     * closes it, so the channels of a multi-channel adapter can be used as separate
+     * QCanBusDevices. A channel can only be held by one backend at a time.
+     * Channels receiving merged through ZCAN_ReceiveData share one receive engine
+     * per adapter, started by the first subscriber and stopped with the last.
+     * Merged reception is a device-wide setting, so the first channel asking for
+     * the receive mode decides it with merge_receive() and the channels opened
+     * later follow, whatever they asked for.
+     * set_value() remembers what it last wrote to each ZCAN_SetValue path of an
+     * adapter and skips writing the same value again until the adapter is closed.
+     * ZCAN_TransmitData is a device call, so the channels of an adapter serialize
+     * it on the adapter's transmit mutex, valid while they hold the adapter.
+     * device_info() queries an adapter nobody holds by opening it briefly; an
+     * acquire() of that adapter meanwhile waits up to probe_wait ms for the probe
+     * to close it again, and fails if the driver takes longer.
+     */
+    class DeviceRegistry
+    {
+        DeviceRegistry(const DeviceRegistry&) = delete;
+        DeviceRegistry& operator=(const DeviceRegistry&) = delete;
+        DeviceRegistry(DeviceRegistry&&) = delete;
+        DeviceRegistry& operator=(DeviceRegistry&&) = delete;
+
+    public:
+        static constexpr int probe_wait{3000};
+
+        static DeviceRegistry* instance();
+
+        DEVICE_HANDLE acquire(unsigned int type, unsigned int index, unsigned int channel);
+        void release(unsigned int type, unsigned int index, unsigned int channel);
+        int channels(unsigned int type, unsigned int index) const;
+        ChannelMutex* transmit_mutex(unsigned int type, unsigned int index) const;
+        bool merge_receive(unsigned int type, unsigned int index, bool requested);
+        bool set_value(unsigned int type, unsigned int index, const QByteArray& path, const QByteArray& value);
+        bool device_info(unsigned int type, unsigned int index, ZCAN_DEVICE_INFO& info);
+
+        void subscribe(unsigned int type, unsigned int index, unsigned int channel, ReceiveSubscriber* subscriber, int wait_time);
+        void unsubscribe(unsigned int type, unsigned int index, unsigned int channel);
+
+    private:
+        DeviceRegistry() = default;
+
+        bool wait_probed(const QPair<unsigned int, unsigned int>& key);
+
+        struct Entry
+        {
+            DEVICE_HANDLE handle{INVALID_DEVICE_HANDLE};
+            QSet<unsigned int> channels{};
+            ZlgCanReceiveEngine* engine{};
+            QSharedPointer<ChannelMutex> transmit_mutex{QSharedPointer<ChannelMutex>::create()};
+            // -1 until a channel decided the receive mode, then 0 or 1
+            int merge_receive{-1};
+            QHash<QByteArray, QByteArray> values{};
+        };
+
+        mutable QMutex _mutex{};
+        QHash<QPair<unsigned int, unsigned int>, Entry> _devices{};
+        QSet<QPair<unsigned int, unsigned int>> _probing{};
+        QWaitCondition _probed{};
+    };
+} //namespace zlg
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANREGISTRY_P_H
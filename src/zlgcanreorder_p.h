@@ -0,0 +1,89 @@
+#ifndef ZLGCANREORDER_P_H
+#define ZLGCANREORDER_P_H
+
+#include <QVector>
+#include <QtGlobal>
+
+#include <cstddef>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    /*!
+     * Holds the records read from one vendor receive queue, together with the host
+     * time they were read at, until the reorder stage releases them in timestamp order.
+     * Records of one queue are already ordered, so only the front is ever compared.
+     */
+    template<typename T>
+    class ReorderQueue
+    {
+    public:
+        void append(const T* data, std::size_t size, qint64 now)
+        {
+            for(auto i{std::size_t{0}}; i < size; ++i)
+            {
+                _records.append(data[i]);
+                _arrivals.append(now);
+            }
+        }
+
+        void pop(std::size_t count)
+        {
+            _head += static_cast<int>(count);
+            if(_head == _records.size())
+            {
+                _records.resize(0);
+                _arrivals.resize(0);
+                _head = 0;
+            }
+            else if(_head >= _records.size() / 2)
+            {
+                _records.remove(0, _head);
+                _arrivals.remove(0, _head);
+                _head = 0;
+            }
+        }
+
+        void clear()
+        {
+            _records.resize(0);
+            _arrivals.resize(0);
+            _head = 0;
+        }
+
+        bool empty() const
+        {
+            return _head == _records.size();
+        }
+
+        std::size_t size() const
+        {
+            return static_cast<std::size_t>(_records.size() - _head);
+        }
+
+        const T* data() const
+        {
+            return _records.constData() + _head;
+        }
+
+        quint64 timestamp(std::size_t index = 0) const
+        {
+            return _records[_head + static_cast<int>(index)].timestamp;
+        }
+
+        qint64 arrival(std::size_t index = 0) const
+        {
+            return _arrivals[_head + static_cast<int>(index)];
+        }
+
+    private:
+        QVector<T> _records{};
+        QVector<qint64> _arrivals{};
+        int _head{0};
+    };
+} //namespace zlg
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANREORDER_P_H
@@ -0,0 +1,146 @@
+#ifndef ZLGCANRING_P_H
+#define ZLGCANRING_P_H
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    /*!
+     * Fixed-capacity single-producer/single-consumer ring of trivially copyable records.
+     * push() is only called by the producer thread and pop() only by the consumer thread;
+     * reset() must not race with either.
+     */
+    template<typename T>
+    class SpscRing
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "SpscRing only stores trivially copyable records");
+
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+    public:
+        static constexpr std::size_t cache_line_size{64};
+
+        SpscRing() = default;
+
+        void reset(std::size_t capacity)
+        {
+            capacity = std::bit_ceil(std::max<std::size_t>(capacity, 2));
+            _buffer = std::make_unique<T[]>(capacity);
+            _mask = capacity - 1;
+            _head.store(0, std::memory_order_relaxed);
+            _tail.store(0, std::memory_order_relaxed);
+            _cached_head = 0;
+            _cached_tail = 0;
+            _overflows.store(0, std::memory_order_relaxed);
+            _high_water_mark.store(0, std::memory_order_relaxed);
+        }
+
+        std::size_t push(const T* items, std::size_t size)
+        {
+            if(Q_UNLIKELY(!_buffer))
+            {
+                _overflows.fetch_add(size, std::memory_order_relaxed);
+                return 0;
+            }
+
+            const auto head{_head.load(std::memory_order_relaxed)};
+            if(capacity() - (head - _cached_tail) < size)
+            {
+                _cached_tail = _tail.load(std::memory_order_acquire);
+            }
+            const auto count{std::min(size, capacity() - (head - _cached_tail))};
+            const auto offset{head & _mask};
+            const auto first{std::min(count, capacity() - offset)};
+            ::memcpy(&_buffer[offset], items, first * sizeof(T));
+            ::memcpy(&_buffer[0], items + first, (count - first) * sizeof(T));
+            _head.store(head + count, std::memory_order_release);
+
+            if(count < size)
+            {
+                _overflows.fetch_add(size - count, std::memory_order_relaxed);
+            }
+            const auto used{head + count - _cached_tail};
+            if(used > _high_water_mark.load(std::memory_order_relaxed))
+            {
+                _high_water_mark.store(used, std::memory_order_relaxed);
+            }
+            return count;
+        }
+
+        // copies the oldest records without consuming them, consumer thread only
+        std::size_t peek(T* items, std::size_t size)
+        {
+            if(Q_UNLIKELY(!_buffer))
+            {
+                return 0;
+            }
+
+            const auto tail{_tail.load(std::memory_order_relaxed)};
+            if(_cached_head - tail < size)
+            {
+                _cached_head = _head.load(std::memory_order_acquire);
+            }
+            const auto count{std::min(size, _cached_head - tail)};
+            const auto offset{tail & _mask};
+            const auto first{std::min(count, capacity() - offset)};
+            ::memcpy(items, &_buffer[offset], first * sizeof(T));
+            ::memcpy(items + first, &_buffer[0], (count - first) * sizeof(T));
+            return count;
+        }
+
+        std::size_t pop(T* items, std::size_t size)
+        {
+            const auto count{peek(items, size)};
+            _tail.store(_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+            return count;
+        }
+
+        std::size_t capacity() const
+        {
+            return _buffer ? _mask + 1 : 0;
+        }
+
+        std::size_t size() const
+        {
+            return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+        }
+
+        quint64 overflows() const
+        {
+            return _overflows.load(std::memory_order_relaxed);
+        }
+
+        std::size_t high_water_mark() const
+        {
+            return _high_water_mark.load(std::memory_order_relaxed);
+        }
+
+    private:
+        // producer side
+        alignas(cache_line_size) std::atomic<std::size_t> _head{0};
+        std::size_t _cached_tail{0};
+        std::atomic<quint64> _overflows{0};
+        std::atomic<std::size_t> _high_water_mark{0};
+
+        // consumer side
+        alignas(cache_line_size) std::atomic<std::size_t> _tail{0};
+        std::size_t _cached_head{0};
+
+        alignas(cache_line_size) std::unique_ptr<T[]> _buffer{};
+        std::size_t _mask{0};
+    };
+} //namespace zlg
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANRING_P_H
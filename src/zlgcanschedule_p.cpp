@@ -0,0 +1,159 @@
+#include "zlgcanschedule_p.h"
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    constexpr quint64 max_delay{0xFFFF};
+
+    struct Delay
+    {
+        bool unit_100us{true};
+        quint16 value{0};
+    };
+
+    Delay to_delay(quint64 gap)
+    {
+        // 100 us units cover gaps up to 6.5 s, longer gaps fall back to 1 ms units and are clamped past 65 s
+        const auto units{gap / 100};
+        if(units <= max_delay)
+        {
+            return {true, static_cast<quint16>(units)};
+        }
+        return {false, static_cast<quint16>(qMin((units + 5) / 10, max_delay))};
+    }
+
+    void TransmitSchedule::reset(const QVector<ZlgCanBackend::ScheduledFrame>& frames)
+    {
+        _frames = frames;
+        std::stable_sort(_frames.begin(), _frames.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.time < rhs.time;
+        });
+        _cursor = 0;
+        _start = -1;
+        _echo_offset = std::numeric_limits<qint64>::max();
+        _samples = 0;
+        _drift_sum = 0;
+        _statistics = {};
+        _statistics.queued = _frames.size();
+    }
+
+    void TransmitSchedule::clear()
+    {
+        _frames.clear();
+        _cursor = 0;
+        _start = -1;
+    }
+
+    bool TransmitSchedule::active() const
+    {
+        return _cursor < size();
+    }
+
+    std::size_t TransmitSchedule::cursor() const
+    {
+        return _cursor;
+    }
+
+    std::size_t TransmitSchedule::size() const
+    {
+        return static_cast<std::size_t>(_frames.size());
+    }
+
+    const QCanBusFrame& TransmitSchedule::frame(std::size_t index) const
+    {
+        return _frames[static_cast<int>(index)].frame;
+    }
+
+    qint64 TransmitSchedule::time(std::size_t index) const
+    {
+        return static_cast<qint64>(_frames[static_cast<int>(index)].time);
+    }
+
+    quint64 TransmitSchedule::gap(std::size_t index) const
+    {
+        if(index + 1 >= size())
+        {
+            return 0;
+        }
+        const auto rounded{[](quint64 time) {
+            return (time + 50) / 100 * 100;
+        }};
+        return rounded(_frames[static_cast<int>(index) + 1].time) - rounded(_frames[static_cast<int>(index)].time);
+    }
+
+    void TransmitSchedule::advance(std::size_t count)
+    {
+        _cursor = qMin(_cursor + count, size());
+        _statistics.sent += count;
+    }
+
+    qint64 TransmitSchedule::start() const
+    {
+        return _start;
+    }
+
+    void TransmitSchedule::start(qint64 now)
+    {
+        _start = now;
+    }
+
+    void TransmitSchedule::record_underrun()
+    {
+        ++_statistics.underruns;
+    }
+
+    void TransmitSchedule::record_drift(qint64 drift)
+    {
+        ++_samples;
+        _drift_sum += drift;
+        if(qAbs(drift) > qAbs(_statistics.maxDrift))
+        {
+            _statistics.maxDrift = drift;
+        }
+        _statistics.meanDrift = _drift_sum / static_cast<qint64>(_samples);
+    }
+
+    void TransmitSchedule::record_echo(qint64 offset)
+    {
+        // the first echo anchors the device clock to the schedule
+        if(std::numeric_limits<qint64>::max() == _echo_offset)
+        {
+            _echo_offset = offset;
+        }
+        record_drift(offset - _echo_offset);
+    }
+
+    ZlgCanBackend::ScheduleStatistics TransmitSchedule::statistics() const
+    {
+        return _statistics;
+    }
+
+    void set_delay(ZCAN_Transmit_Data& data, quint64 gap)
+    {
+        const auto delay{to_delay(gap)};
+        data.frame.__pad |= TX_DELAY_SEND_FLAG | (delay.unit_100us ? TX_DELAY_SEND_TIME_UNIT_FLAG : 0);
+        data.frame.__res0 = static_cast<BYTE>(delay.value & 0xFF);
+        data.frame.__res1 = static_cast<BYTE>(delay.value >> 8);
+    }
+
+    void set_delay(ZCAN_TransmitFD_Data& data, quint64 gap)
+    {
+        const auto delay{to_delay(gap)};
+        data.frame.flags |= TX_DELAY_SEND_FLAG | (delay.unit_100us ? TX_DELAY_SEND_TIME_UNIT_FLAG : 0);
+        data.frame.__res0 = static_cast<BYTE>(delay.value & 0xFF);
+        data.frame.__res1 = static_cast<BYTE>(delay.value >> 8);
+    }
+
+    void set_delay(ZCANDataObj& data, quint64 gap)
+    {
+        const auto delay{to_delay(gap)};
+        auto& can_data{data.data.zcanCANFDData};
+        can_data.flag.unionVal.txDelay = delay.unit_100us ? ZCAN_TX_DELAY_UNIT_100US : ZCAN_TX_DELAY_UNIT_MS;
+        can_data.timeStamp = delay.value;
+    }
+} //namespace zlg
+
+QT_END_NAMESPACE
@@ -0,0 +1,63 @@
+#ifndef ZLGCANSCHEDULE_P_H
+#define ZLGCANSCHEDULE_P_H
+
+#include "zlgcanbackend.h"
+
+#include <QVector>
+#include <QtGlobal>
+#include <zlgcan/zlgcan.h>
+
+#include <cstddef>
+#include <limits>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    /*!
+     * Frames waiting to be handed to the device's delayed send queue. The device
+     * sends a queued frame, then waits the frame's delay before the next one, so
+     * each frame carries the gap to its successor. Gaps are taken from send times
+     * rounded to 100 us, which keeps the rounding error from adding up over a trace.
+     */
+    class TransmitSchedule
+    {
+    public:
+        void reset(const QVector<ZlgCanBackend::ScheduledFrame>& frames);
+        void clear();
+
+        bool active() const;
+        std::size_t cursor() const;
+        std::size_t size() const;
+        const QCanBusFrame& frame(std::size_t index) const;
+        qint64 time(std::size_t index) const;
+        quint64 gap(std::size_t index) const;
+        void advance(std::size_t count);
+
+        qint64 start() const;
+        void start(qint64 now);
+
+        void record_underrun();
+        void record_drift(qint64 drift);
+        void record_echo(qint64 offset);
+        ZlgCanBackend::ScheduleStatistics statistics() const;
+
+    private:
+        QVector<ZlgCanBackend::ScheduledFrame> _frames{};
+        std::size_t _cursor{0};
+        qint64 _start{-1};
+        qint64 _echo_offset{std::numeric_limits<qint64>::max()};
+
+        quint64 _samples{0};
+        qint64 _drift_sum{0};
+        ZlgCanBackend::ScheduleStatistics _statistics{};
+    };
+
+    void set_delay(ZCAN_Transmit_Data& data, quint64 gap);
+    void set_delay(ZCAN_TransmitFD_Data& data, quint64 gap);
+    void set_delay(ZCANDataObj& data, quint64 gap);
+} //namespace zlg
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANSCHEDULE_P_H
@@ -0,0 +1,132 @@
+#include "zlgcantrace_p.h"
+
+#include <QFile>
+
+QT_BEGIN_NAMESPACE
+
+namespace zlg
+{
+    void TraceBuffer::append(const TraceEvent& event)
+    {
+        const auto head{_head.load(std::memory_order_relaxed)};
+        auto& slot{_slots[head % capacity]};
+        // odd while the slot is written, then the event's position plus one, times two
+        slot.sequence.store(head * 2 + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.event = event;
+        slot.sequence.store(head * 2 + 2, std::memory_order_release);
+        _head.store(head + 1, std::memory_order_release);
+    }
+
+    QVector<TraceEvent> TraceBuffer::events() const
+    {
+        const auto head{_head.load(std::memory_order_acquire)};
+        const auto begin{head > capacity ? head - capacity : 0};
+
+        QVector<TraceEvent> events{};
+        events.reserve(static_cast<int>(head - begin));
+        for(auto position{begin}; position < head; ++position)
+        {
+            const auto& slot{_slots[position % capacity]};
+            const auto sequence{slot.sequence.load(std::memory_order_acquire)};
+            const auto event{slot.event};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(sequence == position * 2 + 2 && slot.sequence.load(std::memory_order_relaxed) == sequence)
+            {
+                events.append(event);
+            }
+        }
+        return events;
+    }
+
+    Tracer::Tracer()
+    {
+        _clock.start();
+    }
+
+    Tracer* Tracer::instance()
+    {
+        static Tracer instance{};
+        return &instance;
+    }
+
+    TraceBuffer* Tracer::buffer()
+    {
+        struct Holder
+        {
+            TraceBuffer* buffer{};
+
+            ~Holder()
+            {
+                if(buffer)
+                {
+                    Tracer::instance()->release(buffer);
+                }
+            }
+        };
+        thread_local Holder holder{};
+
+        if(Q_UNLIKELY(!holder.buffer))
+        {
+            const QMutexLocker locker{&_mutex};
+            if(_free_buffers.isEmpty())
+            {
+                _buffers.append(new TraceBuffer(_buffers.size() + 1));
+                holder.buffer = _buffers.last();
+            }
+            else
+            {
+                holder.buffer = _free_buffers.takeLast();
+            }
+        }
+        return holder.buffer;
+    }
+
+    qint64 Tracer::now() const
+    {
+        return _clock.nsecsElapsed();
+    }
+
+    bool Tracer::dump(const QString& file_name) const
+    {
+        QFile file{file_name};
+        if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            return false;
+        }
+
+        // Chrome trace event format, complete events with timestamps in us
+        QByteArray json{"{\"traceEvents\":["};
+        auto first{true};
+        const QMutexLocker locker{&_mutex};
+        for(const auto* buffer: _buffers)
+        {
+            for(const auto& event: buffer->events())
+            {
+                json.append(first ? "\n" : ",\n");
+                first = false;
+                json.append(QString("{\"name\":\"%1\",\"ph\":\"X\",\"pid\":1,\"tid\":%2,\"ts\":%3,\"dur\":%4")
+                                .arg(QString::fromLatin1(event.name))
+                                .arg(buffer->thread())
+                                .arg(event.begin / 1000.0, 0, 'f', 3)
+                                .arg(event.duration / 1000.0, 0, 'f', 3)
+                                .toLatin1());
+                if(event.value >= 0)
+                {
+                    json.append(QString(",\"args\":{\"value\":%1}").arg(event.value).toLatin1());
+                }
+                json.append("}");
+            }
+        }
+        json.append("\n]}\n");
+        return file.write(json) == json.size();
+    }
+
+    void Tracer::release(TraceBuffer* buffer)
+    {
+        const QMutexLocker locker{&_mutex};
+        _free_buffers.append(buffer);
+    }
+} //namespace zlg
+
+QT_END_NAMESPACE
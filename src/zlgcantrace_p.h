@@ -0,0 +1,123 @@
+#ifndef ZLGCANTRACE_P_H
+#define ZLGCANTRACE_P_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+QT_BEGIN_NAMESPACE
+
+#if defined(ZLGCAN_TRACE)
+#define ZLGCAN_TRACE_SCOPE(scope, name) zlg::TraceScope scope{name}
+#define ZLGCAN_TRACE_VALUE(scope, value) scope.set_value(static_cast<qint64>(value))
+#else
+#define ZLGCAN_TRACE_SCOPE(scope, name)
+#define ZLGCAN_TRACE_VALUE(scope, value)
+#endif
+
+namespace zlg
+{
+    // begin and duration in ns since the tracer started, value is -1 when the scope set none
+    struct TraceEvent
+    {
+        const char* name{};
+        qint64 begin{0};
+        qint64 duration{0};
+        qint64 value{-1};
+    };
+
+    /*!
+     * Ring of the most recent events of one thread. Only the owning thread appends;
+     * each slot carries a sequence number so a concurrent dump skips slots that are
+     * being overwritten instead of reading them torn.
+     */
+    class TraceBuffer
+    {
+        TraceBuffer(const TraceBuffer&) = delete;
+        TraceBuffer& operator=(const TraceBuffer&) = delete;
+
+    public:
+        static constexpr std::size_t capacity{8192};
+
+        explicit TraceBuffer(int thread): _thread(thread) {}
+
+        void append(const TraceEvent& event);
+        QVector<TraceEvent> events() const;
+        int thread() const
+        {
+            return _thread;
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<quint64> sequence{0};
+            TraceEvent event{};
+        };
+
+        const int _thread{0};
+        std::atomic<quint64> _head{0};
+        Slot _slots[capacity]{};
+    };
+
+    /*!
+     * Hands every thread its own TraceBuffer on first use, so recording takes no lock.
+     * Buffers of finished threads are kept for dump() and handed to the next new thread.
+     */
+    class Tracer
+    {
+        Tracer(const Tracer&) = delete;
+        Tracer& operator=(const Tracer&) = delete;
+
+    public:
+        static Tracer* instance();
+
+        TraceBuffer* buffer();
+        qint64 now() const;
+        bool dump(const QString& file_name) const;
+
+    private:
+        Tracer();
+
+        void release(TraceBuffer* buffer);
+
+        QElapsedTimer _clock{};
+        mutable QMutex _mutex{};
+        QVector<TraceBuffer*> _buffers{};
+        QVector<TraceBuffer*> _free_buffers{};
+    };
+
+    class TraceScope
+    {
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+
+    public:
+        explicit TraceScope(const char* name)
+        {
+            _event.name = name;
+            _event.begin = Tracer::instance()->now();
+        }
+
+        ~TraceScope()
+        {
+            _event.duration = Tracer::instance()->now() - _event.begin;
+            Tracer::instance()->buffer()->append(_event);
+        }
+
+        void set_value(qint64 value)
+        {
+            _event.value = value;
+        }
+
+    private:
+        TraceEvent _event{};
+    };
+} //namespace zlg
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANTRACE_P_H
@@ -0,0 +1,161 @@
+#include "zlgcantransmitter_p.h"
+
+#include <QElapsedTimer>
+
+QT_BEGIN_NAMESPACE
+
+ZlgCanTransmitter::ZlgCanTransmitter(const zlg::Loader* dll, const Context& context, QObject* parent): QThread(parent), dll(dll), _context(context)
+{
+}
+
+ZlgCanTransmitter::~ZlgCanTransmitter()
+{
+    stop();
+}
+
+void ZlgCanTransmitter::stop()
+{
+    requestInterruption();
+    _context.queue->close();
+    wait();
+}
+
+void ZlgCanTransmitter::run()
+{
+    QCanBusFrame frames[64]{};
+    constexpr auto frames_size{sizeof(frames) / sizeof(frames[0])};
+
+    auto offset{std::size_t{0}};
+    auto size{std::size_t{0}};
+    auto backoff{0UL};
+    auto failures{0};
+    QElapsedTimer stalled{};
+    while(!isInterruptionRequested())
+    {
+        if(offset == size)
+        {
+            offset = 0;
+            size = _context.queue->pop(frames, frames_size, 50);
+            for(auto i{std::size_t{0}}; i < size; ++i)
+            {
+                if(_context.transmit_data)
+                {
+                    zlg::to_transmit_data(frames[i], _context.channel_index, _context.tx_echo, _data_obj[i]);
+                    if(_context.tx_echo)
+                    {
+                        zlg::set_echo_tag(_data_obj[i], *_context.echo_sequence);
+                    }
+                }
+                else if(_context.fd_enabled)
+                {
+                    zlg::to_transmit_data(frames[i], _fd_data[i]);
+                }
+                else
+                {
+                    zlg::to_transmit_data(frames[i], _data[i]);
+                }
+            }
+            continue;
+        }
+
+        // echoes are matched in transmit order, so frames wait for room rather than go out without an entry
+        auto count{size - offset};
+        if(_context.tx_echo)
+        {
+            count = qMin(count, _context.pending_echoes->capacity() - _context.pending_echoes->size());
+            if(!count)
+            {
+                QThread::usleep(max_backoff);
+                continue;
+            }
+        }
+
+        const auto result{send(offset, count)};
+        if(result)
+        {
+            offset += result;
+            failures = 0;
+            stalled.invalidate();
+            emit framesSent(result);
+        }
+        if(result == count)
+        {
+            backoff = 0;
+            continue;
+        }
+
+        // the device refused the tail of the batch; a full device queue is worth waiting for a while, anything else a few times
+        const auto error_code{errorCode()};
+        const auto transient{result || ZCAN_ERROR_SEND_TOO_FAST == error_code || ZCAN_ERROR_SEND_PARTIAL == error_code || ZCAN_ERROR_CAN_BUFFER_OVERFLOW == error_code || ZCAN_ERROR_BUFFEROVERFLOW == error_code};
+        if(!stalled.isValid())
+        {
+            stalled.start();
+        }
+        if(transient ? stalled.elapsed() >= max_stall_time : ++failures >= max_failures)
+        {
+            emit transmitFailed(error_code, static_cast<qint64>(size - offset));
+            offset = size;
+            failures = 0;
+            backoff = 0;
+            stalled.invalidate();
+            continue;
+        }
+        backoff = qBound(min_backoff, backoff * 2, max_backoff);
+        QThread::usleep(backoff);
+    }
+}
+
+unsigned int ZlgCanTransmitter::send(std::size_t offset, std::size_t size)
+{
+    auto result{0U};
+    {
+        const zlg::ChannelLocker locker{*_context.tx_mutex};
+        if(_context.transmit_data)
+        {
+            const zlg::ChannelLocker device_locker{*_context.device_tx_mutex};
+            result = _context.counters->call(ZlgCanBackend::TransmitDataFunction, [&]() {
+                return dll->ZCAN_TransmitData(_context.device_handle, _data_obj + offset, static_cast<UINT>(size));
+            });
+            _context.counters->transmitted(_data_obj + offset, result);
+        }
+        else if(_context.fd_enabled)
+        {
+            result = _context.counters->call(ZlgCanBackend::TransmitFDFunction, [&]() {
+                return dll->ZCAN_TransmitFD(_context.channel_handle, _fd_data + offset, static_cast<UINT>(size));
+            });
+            _context.counters->transmitted(_fd_data + offset, result);
+        }
+        else
+        {
+            result = _context.counters->call(ZlgCanBackend::TransmitFunction, [&]() {
+                return dll->ZCAN_Transmit(_context.channel_handle, _data + offset, static_cast<UINT>(size));
+            });
+            _context.counters->transmitted(_data + offset, result);
+        }
+    }
+
+    if(_context.tx_echo && result)
+    {
+        zlg::PendingEcho echoes[64]{};
+        const auto now{_context.clock->nsecsElapsed() / 1000};
+        for(auto i{0U}; i < result; ++i)
+        {
+            echoes[i] = {_data_obj[offset + i].data.zcanCANFDData.frame.can_id, zlg::echo_tag(_data_obj[offset + i]), now};
+        }
+        _context.pending_echoes->push(echoes, result);
+    }
+    return result;
+}
+
+unsigned int ZlgCanTransmitter::errorCode() const
+{
+    ZCAN_CHANNEL_ERR_INFO info{};
+    ::memset(&info, 0, sizeof(info));
+    {
+        const zlg::ChannelLocker locker{*_context.control_mutex};
+        _context.channel_errors->read(zlg::ChannelErrors::TRANSMIT, dll, _context.channel_handle, *_context.counters, info);
+    }
+    return info.error_code;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,77 @@
+#ifndef ZLGCANTRANSMITTER_P_H
+#define ZLGCANTRANSMITTER_P_H
+
+#include "zlgcanbackend_p.h"
+#include "zlgcanqueue_p.h"
+#include "zlgcanring_p.h"
+
+#include <QCanBusFrame>
+#include <QThread>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+ * Takes batches of frames from the transmit queue on a dedicated thread and hands
+ * them to ZCAN_Transmit, ZCAN_TransmitFD or ZCAN_TransmitData. When the device
+ * refuses part of a batch, only the unsent tail is retried after an exponential backoff:
+ * for max_stall_time ms while the device reports a full queue, max_failures times for
+ * any other error. With tx echo, a batch only goes out as far as the pending echo ring
+ * has room, so no echo loses its entry.
+ */
+class ZlgCanTransmitter: public QThread
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(ZlgCanTransmitter)
+
+public:
+    struct Context
+    {
+        DEVICE_HANDLE device_handle{INVALID_DEVICE_HANDLE};
+        CHANNEL_HANDLE channel_handle{INVALID_CHANNEL_HANDLE};
+        unsigned int channel_index{0};
+        bool fd_enabled{false};
+        bool transmit_data{false};
+        bool tx_echo{false};
+        zlg::ChannelMutex* tx_mutex{};
+        zlg::ChannelMutex* device_tx_mutex{};
+        zlg::ChannelMutex* control_mutex{};
+        zlg::ChannelErrors* channel_errors{};
+        zlg::MpscQueue<QCanBusFrame>* queue{};
+        zlg::SpscRing<zlg::PendingEcho>* pending_echoes{};
+        quint32* echo_sequence{};
+        const QElapsedTimer* clock{};
+        zlg::PerformanceCounters* counters{};
+    };
+
+    static constexpr unsigned long min_backoff{100};
+    static constexpr unsigned long max_backoff{10000};
+    static constexpr int max_failures{16};
+    static constexpr qint64 max_stall_time{1000};
+
+    explicit ZlgCanTransmitter(const zlg::Loader* dll, const Context& context, QObject* parent = nullptr);
+    ~ZlgCanTransmitter();
+
+    void stop();
+
+signals:
+    void framesSent(qint64 count);
+    void transmitFailed(unsigned int error_code, qint64 dropped);
+
+protected:
+    void run() override;
+
+private:
+    unsigned int send(std::size_t offset, std::size_t size);
+    unsigned int errorCode() const;
+
+    const zlg::Loader* dll{};
+    Context _context{};
+
+    ZCAN_Transmit_Data _data[64]{};
+    ZCAN_TransmitFD_Data _fd_data[64]{};
+    ZCANDataObj _data_obj[64]{};
+};
+
+QT_END_NAMESPACE
+
+#endif // ZLGCANTRANSMITTER_P_H
@@ -0,0 +1,602 @@
+#include "zlgcandevices_p.h"
+#include "zlgcanmock.h"
+#include "zlgcantools.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QLibrary>
+#include <QTimer>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+/*!
+ * Soak test of ZlgCanBackend. Every device index is one bus: channel 0 sends
+ * numbered frames at a fixed rate and every other channel checks that it sees all
+ * of them in order. Faults are injected through the simulated libzlgcan
+ * (ZLGCAN_MOCK) on one bus at a time while the others keep running:
+ *
+ * - error passive: bus status Error while it lasts, Good once cleared.
+ * - bus off: bus status BusOff while it lasts, Good after resetController.
+ * - unplug: bus status Unknown on every channel, Good on every channel after
+ *   the device is plugged back in and each channel is reset.
+ *
+ * The sender of the faulted bus pauses until all frames in flight have arrived,
+ * so every sequence gap is a lost frame. The run fails on lost or reordered
+ * frames, refused writes, wrong bus states or resident memory growing more than
+ * --memory-growth MiB past the first report interval. ZLGCAN_MOCK_CHANNELS has
+ * to cover --channels, and ZLGCAN_MOCK_ERROR_RATE should stay 0 since random
+ * bus errors make the state checks fail.
+ */
+namespace zlg::stress
+{
+    struct Options: tools::Options
+    {
+        int devices{4};
+        int channels{2};
+        int rate{2000};
+        int duration{3600};
+        int fault_interval{30};
+        int fault_time{1000};
+        int drain_time{2000};
+        int report_interval{10};
+        int window{65536};
+        qint64 memory_growth{64};
+    };
+
+    // resident set size in bytes, 0 where it cannot be read
+    struct Memory
+    {
+        qint64 current{0};
+        qint64 peak{0};
+    };
+
+    Memory memory()
+    {
+        Memory result{};
+#if defined(Q_OS_WIN)
+        PROCESS_MEMORY_COUNTERS counters{};
+        if(::GetProcessMemoryInfo(::GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            result.current = static_cast<qint64>(counters.WorkingSetSize);
+            result.peak = static_cast<qint64>(counters.PeakWorkingSetSize);
+        }
+#else
+        QFile file{"/proc/self/status"};
+        if(file.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            for(const auto& line: file.readAll().split('\n'))
+            {
+                const auto value{line.mid(6).trimmed().split(' ').value(0).toLongLong() * 1024};
+                if(line.startsWith("VmRSS:"))
+                {
+                    result.current = value;
+                }
+                else if(line.startsWith("VmHWM:"))
+                {
+                    result.peak = value;
+                }
+            }
+        }
+#endif
+        return result;
+    }
+
+    QString fault_name(unsigned int fault)
+    {
+        switch(fault)
+        {
+            case mock::ErrorPassiveFault: return "error_passive";
+            case mock::BusOffFault: return "bus_off";
+            case mock::UnplugFault: return "unplug";
+            default: return "none";
+        }
+    }
+
+    QString status_name(QCanBusDevice::CanBusStatus status)
+    {
+        switch(status)
+        {
+            case QCanBusDevice::CanBusStatus::Good: return "good";
+            case QCanBusDevice::CanBusStatus::Warning: return "warning";
+            case QCanBusDevice::CanBusStatus::Error: return "error";
+            case QCanBusDevice::CanBusStatus::BusOff: return "bus_off";
+            default: return "unknown";
+        }
+    }
+
+    class Harness
+    {
+        Q_DISABLE_COPY(Harness)
+
+    public:
+        explicit Harness(const Options& options);
+
+        bool open(QString& error);
+        QJsonObject run();
+
+    private:
+        struct Bus
+        {
+            unsigned int index{0};
+            std::vector<std::unique_ptr<ZlgCanBackend>> backends{};
+            std::vector<quint64> expected{};
+            quint64 sequence{0};
+            double credit{0.0};
+            bool paused{false};
+        };
+
+        struct Fault
+        {
+            qint64 time{0};
+            int bus{0};
+            int channel{0};
+            unsigned int type{mock::ClearFault};
+            bool drained{false};
+            QString during{};
+            QString after{};
+            bool passed{false};
+        };
+
+        enum class Phase
+        {
+            Running,
+            Draining,
+            Faulted,
+            Finishing,
+        };
+
+        void tick();
+        void feed(Bus& bus, qint64 interval);
+        void receive(Bus& bus, std::size_t channel);
+        void report();
+        void inject();
+        void recover();
+        quint64 slowest(const Bus& bus) const;
+        bool drained(const Bus& bus) const;
+        QCanBusFrame frame(quint64 sequence) const;
+
+        Options _options{};
+        unsigned int _device_type{0};
+        pf_ZCAN_MOCK_InjectFault _inject{};
+        std::vector<Bus> _buses{};
+
+        QEventLoop _loop{};
+        QTimer _tick_timer{};
+        QTimer _report_timer{};
+        QElapsedTimer _clock{};
+        qint64 _last_tick{0};
+        qint64 _end{0};
+
+        Phase _phase{Phase::Running};
+        qint64 _phase_start{0};
+        qint64 _next_fault{0};
+        Fault _fault{};
+        QJsonArray _faults{};
+        bool _faults_passed{true};
+
+        qint64 _sent{0};
+        qint64 _received{0};
+        qint64 _lost{0};
+        qint64 _out_of_order{0};
+        qint64 _write_failures{0};
+        qint64 _throttled{0};
+        quint64 _backlog_max{0};
+        quint64 _interval_backlog_max{0};
+        qint64 _interval_received{0};
+        qint64 _last_report{0};
+        quint64 _last_overflows{0};
+        qint64 _memory_baseline{0};
+        QJsonArray _samples{};
+    };
+
+    Harness::Harness(const Options& options): _options(options)
+    {
+        _device_type = zlg::get_device_type(options.device);
+        _inject = reinterpret_cast<pf_ZCAN_MOCK_InjectFault>(QLibrary::resolve("zlgcan", "ZCAN_MOCK_InjectFault"));
+
+        _tick_timer.setTimerType(Qt::PreciseTimer);
+        _tick_timer.setInterval(1);
+        QObject::connect(&_tick_timer, &QTimer::timeout, [this]() {
+            tick();
+        });
+        _report_timer.setInterval(options.report_interval * 1000);
+        QObject::connect(&_report_timer, &QTimer::timeout, [this]() {
+            report();
+        });
+    }
+
+    bool Harness::open(QString& error)
+    {
+        if(!_device_type)
+        {
+            error = QString{"Unknown device type %1."}.arg(_options.device);
+            return false;
+        }
+
+        _buses.resize(_options.devices);
+        for(auto i{std::size_t{0}}; i < _buses.size(); ++i)
+        {
+            auto& bus{_buses[i]};
+            bus.index = static_cast<unsigned int>(i);
+            bus.expected.resize(_options.channels);
+            for(auto channel{0}; channel < _options.channels; ++channel)
+            {
+                auto backend{tools::open_backend(_options, bus.index, static_cast<unsigned int>(channel), _options.fd, {}, error)};
+                if(!backend)
+                {
+                    return false;
+                }
+                QObject::connect(backend.get(), &QCanBusDevice::framesReceived, backend.get(), [this, i, channel]() {
+                    receive(_buses[i], static_cast<std::size_t>(channel));
+                });
+                bus.backends.push_back(std::move(backend));
+            }
+        }
+        return true;
+    }
+
+    QJsonObject Harness::run()
+    {
+        _clock.start();
+        _end = static_cast<qint64>(_options.duration) * 1000000000;
+        _next_fault = static_cast<qint64>(_options.fault_interval) * 1000000000;
+        _tick_timer.start();
+        _report_timer.start();
+        _loop.exec();
+        _tick_timer.stop();
+        _report_timer.stop();
+        report();
+
+        const auto final_memory{memory()};
+        const auto growth{final_memory.current - _memory_baseline};
+        QJsonObject memory_report{};
+        memory_report["baseline_bytes"] = static_cast<double>(_memory_baseline);
+        memory_report["final_bytes"] = static_cast<double>(final_memory.current);
+        memory_report["peak_bytes"] = static_cast<double>(final_memory.peak);
+        memory_report["growth_bytes"] = static_cast<double>(growth);
+
+        QJsonObject result{};
+        result["device"] = _options.device;
+        result["devices"] = _options.devices;
+        result["channels"] = _options.channels;
+        result["rate"] = _options.rate;
+        result["duration_s"] = static_cast<double>(_clock.nsecsElapsed()) / 1e9;
+        result["fault_injection"] = nullptr != _inject && _options.fault_interval > 0;
+        result["frames_sent"] = static_cast<double>(_sent);
+        result["frames_received"] = static_cast<double>(_received);
+        result["frames_lost"] = static_cast<double>(_lost);
+        result["frames_out_of_order"] = static_cast<double>(_out_of_order);
+        result["write_failures"] = static_cast<double>(_write_failures);
+        result["throttled"] = static_cast<double>(_throttled);
+        result["backlog_max"] = static_cast<double>(_backlog_max);
+        result["memory"] = memory_report;
+        result["samples"] = _samples;
+        result["faults"] = _faults;
+        result["passed"] = !_lost && !_out_of_order && !_write_failures && _faults_passed && growth <= _options.memory_growth * 1024 * 1024;
+        return result;
+    }
+
+    void Harness::tick()
+    {
+        const auto now{_clock.nsecsElapsed()};
+        const auto interval{now - _last_tick};
+        _last_tick = now;
+        for(auto& bus: _buses)
+        {
+            feed(bus, interval);
+        }
+
+        switch(_phase)
+        {
+            case Phase::Running:
+                if(now >= _end)
+                {
+                    for(auto& bus: _buses)
+                    {
+                        bus.paused = true;
+                    }
+                    _phase = Phase::Finishing;
+                    _phase_start = now;
+                }
+                else if(_inject && _options.fault_interval > 0 && now >= _next_fault)
+                {
+                    // round robin over buses, fault types and channels
+                    const auto count{_faults.size()};
+                    _fault = {};
+                    _fault.time = now;
+                    _fault.bus = count % _options.devices;
+                    _fault.channel = count % _options.channels;
+                    _fault.type = mock::ErrorPassiveFault + count % 3;
+                    _buses[_fault.bus].paused = true;
+                    _phase = Phase::Draining;
+                    _phase_start = now;
+                }
+                break;
+            case Phase::Draining:
+                if(drained(_buses[_fault.bus]) || now - _phase_start >= _options.drain_time * qint64{1000000})
+                {
+                    _fault.drained = drained(_buses[_fault.bus]);
+                    inject();
+                    _phase = Phase::Faulted;
+                    _phase_start = now;
+                }
+                break;
+            case Phase::Faulted:
+                if(now - _phase_start >= _options.fault_time * qint64{1000000})
+                {
+                    recover();
+                    _phase = Phase::Running;
+                    _next_fault = _clock.nsecsElapsed() + _options.fault_interval * qint64{1000000000};
+                }
+                break;
+            case Phase::Finishing:
+                if(std::all_of(_buses.cbegin(), _buses.cend(), [this](const Bus& bus) {
+                    return drained(bus);
+                }) || now - _phase_start >= _options.drain_time * qint64{1000000})
+                {
+                    _loop.quit();
+                }
+                break;
+        }
+    }
+
+    void Harness::feed(Bus& bus, qint64 interval)
+    {
+        if(bus.paused)
+        {
+            bus.credit = 0.0;
+            return;
+        }
+
+        // the credit carries fractions of a frame over to the next tick, so low rates are kept exactly
+        bus.credit += _options.rate * static_cast<double>(interval) / 1e9;
+        auto& sender{*bus.backends.front()};
+        while(bus.credit >= 1.0)
+        {
+            if(bus.sequence - slowest(bus) >= static_cast<quint64>(_options.window))
+            {
+                ++_throttled;
+                bus.credit = 0.0;
+                break;
+            }
+            if(!sender.writeFrame(frame(bus.sequence)))
+            {
+                ++_write_failures;
+                bus.credit = 0.0;
+                break;
+            }
+            ++bus.sequence;
+            ++_sent;
+            bus.credit -= 1.0;
+        }
+        const auto backlog{bus.sequence - slowest(bus)};
+        _backlog_max = qMax(_backlog_max, backlog);
+        _interval_backlog_max = qMax(_interval_backlog_max, backlog);
+    }
+
+    void Harness::receive(Bus& bus, std::size_t channel)
+    {
+        auto& expected{bus.expected[channel]};
+        for(const auto& frame: bus.backends[channel]->readAllFrames())
+        {
+            // the sender only drains its own queue, error frames carry the injected state changes
+            if(!channel || QCanBusFrame::DataFrame != frame.frameType())
+            {
+                continue;
+            }
+            const auto sequence{tools::sequence_of(frame)};
+            if(sequence == expected)
+            {
+                ++expected;
+            }
+            else if(sequence > expected)
+            {
+                _lost += static_cast<qint64>(sequence - expected);
+                expected = sequence + 1;
+            }
+            else
+            {
+                ++_out_of_order;
+            }
+            ++_received;
+            ++_interval_received;
+        }
+    }
+
+    void Harness::report()
+    {
+        const auto now{_clock.nsecsElapsed()};
+        const auto interval{now - _last_report};
+        if(interval <= 0)
+        {
+            return;
+        }
+        auto overflows{quint64{0}};
+        for(const auto& bus: _buses)
+        {
+            for(const auto& backend: bus.backends)
+            {
+                overflows += backend->performanceCounters().bufferOverflows;
+            }
+        }
+        const auto current{memory()};
+        if(_samples.isEmpty())
+        {
+            _memory_baseline = current.current;
+        }
+
+        QJsonObject sample{};
+        sample["time_s"] = static_cast<double>(now) / 1e9;
+        sample["frames_received"] = static_cast<double>(_interval_received);
+        sample["frames_per_second"] = _interval_received * 1e9 / interval;
+        sample["backlog_max"] = static_cast<double>(_interval_backlog_max);
+        sample["buffer_overflows"] = static_cast<double>(overflows - _last_overflows);
+        sample["rss_bytes"] = static_cast<double>(current.current);
+        sample["frames_lost"] = static_cast<double>(_lost);
+        sample["faults"] = _faults.size();
+        _samples.append(sample);
+        std::fprintf(stderr, "%8.1f s %10.0f frames/s backlog %6llu rss %6lld KiB lost %lld faults %d\n", now / 1e9, _interval_received * 1e9 / interval, static_cast<unsigned long long>(_interval_backlog_max), static_cast<long long>(current.current / 1024), static_cast<long long>(_lost), static_cast<int>(_faults.size()));
+
+        _last_report = now;
+        _last_overflows = overflows;
+        _interval_received = 0;
+        _interval_backlog_max = 0;
+    }
+
+    void Harness::inject()
+    {
+        const auto& bus{_buses[_fault.bus]};
+        _inject(_device_type, bus.index, static_cast<UINT>(_fault.channel), _fault.type);
+    }
+
+    void Harness::recover()
+    {
+        auto& bus{_buses[_fault.bus]};
+        // resetController and busStatus are reached through the base class, ZlgCanBackend hides them on Qt 5
+        auto status_of{[&](int channel) {
+            return static_cast<QCanBusDevice&>(*bus.backends[channel]).busStatus();
+        }};
+
+        auto expected{QCanBusDevice::CanBusStatus::Unknown};
+        auto during_passed{true};
+        if(mock::UnplugFault == _fault.type)
+        {
+            for(auto channel{0}; channel < _options.channels; ++channel)
+            {
+                const auto status{status_of(channel)};
+                _fault.during = status_name(status);
+                during_passed = during_passed && expected == status;
+            }
+        }
+        else
+        {
+            expected = mock::ErrorPassiveFault == _fault.type ? QCanBusDevice::CanBusStatus::Error : QCanBusDevice::CanBusStatus::BusOff;
+            const auto status{status_of(_fault.channel)};
+            _fault.during = status_name(status);
+            during_passed = expected == status;
+        }
+
+        if(mock::BusOffFault != _fault.type)
+        {
+            _inject(_device_type, bus.index, static_cast<UINT>(_fault.channel), mock::ClearFault);
+        }
+        if(mock::ErrorPassiveFault != _fault.type)
+        {
+            for(auto channel{0}; channel < _options.channels; ++channel)
+            {
+                if(mock::UnplugFault == _fault.type || channel == _fault.channel)
+                {
+                    static_cast<QCanBusDevice&>(*bus.backends[channel]).resetController();
+                }
+            }
+        }
+
+        auto after_passed{true};
+        for(auto channel{0}; channel < _options.channels; ++channel)
+        {
+            const auto status{status_of(channel)};
+            if(channel == _fault.channel)
+            {
+                _fault.after = status_name(status);
+            }
+            after_passed = after_passed && QCanBusDevice::CanBusStatus::Good == status && QCanBusDevice::ConnectedState == bus.backends[channel]->state();
+        }
+
+        // frames still in flight when the fault hit are only lost if the drain timed out
+        _fault.passed = _fault.drained && during_passed && after_passed;
+        _faults_passed = _faults_passed && _fault.passed;
+        bus.paused = false;
+
+        QJsonObject fault{};
+        fault["time_s"] = static_cast<double>(_fault.time) / 1e9;
+        fault["device"] = _fault.bus;
+        fault["channel"] = _fault.channel;
+        fault["fault"] = fault_name(_fault.type);
+        fault["drained"] = _fault.drained;
+        fault["status_during"] = _fault.during;
+        fault["status_after"] = _fault.after;
+        fault["passed"] = _fault.passed;
+        _faults.append(fault);
+    }
+
+    quint64 Harness::slowest(const Bus& bus) const
+    {
+        auto result{bus.sequence};
+        for(auto i{std::size_t{1}}; i < bus.expected.size(); ++i)
+        {
+            result = qMin(result, bus.expected[i]);
+        }
+        return result;
+    }
+
+    bool Harness::drained(const Bus& bus) const
+    {
+        return slowest(bus) == bus.sequence;
+    }
+
+    QCanBusFrame Harness::frame(quint64 sequence) const
+    {
+        return tools::sequence_frame(0x100, sequence, _options.fd);
+    }
+} //namespace zlg::stress
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app{argc, argv};
+
+    QCommandLineParser parser{};
+    parser.setApplicationDescription("Soak test of ZlgCanBackend with sustained bus load and injected bus faults, summary as JSON.");
+    parser.addHelpOption();
+    const zlg::tools::CommandLine command_line{"ZCAN_USBCANFD_200U"};
+    command_line.addTo(parser);
+    const QCommandLineOption devices_option{"devices", "Buses, one device index each.", "count", "4"};
+    const QCommandLineOption channels_option{"channels", "Channels per bus, channel 0 sends.", "count", "2"};
+    const QCommandLineOption rate_option{"rate", "Frames per second sent on every bus.", "fps", "2000"};
+    const QCommandLineOption duration_option{"duration", "Run time in s.", "s", "3600"};
+    const QCommandLineOption fault_interval_option{"fault-interval", "Time between injected faults in s, 0 disables them.", "s", "30"};
+    const QCommandLineOption fault_time_option{"fault-time", "Time a fault is held in ms.", "ms", "1000"};
+    const QCommandLineOption report_option{"report-interval", "Time between throughput and memory samples in s.", "s", "10"};
+    const QCommandLineOption growth_option{"memory-growth", "Resident memory growth past the first sample that fails the run, in MiB.", "MiB", "64"};
+    const QCommandLineOption fd_option{"fd", "Send 64 byte CAN FD frames."};
+    parser.addOptions({devices_option, channels_option, rate_option, duration_option, fault_interval_option, fault_time_option, report_option, growth_option, fd_option});
+    parser.process(app);
+
+    zlg::stress::Options options{};
+    command_line.read(parser, options);
+    options.devices = qMax(parser.value(devices_option).toInt(), 1);
+    options.channels = qMax(parser.value(channels_option).toInt(), 2);
+    options.rate = qMax(parser.value(rate_option).toInt(), 1);
+    options.duration = qMax(parser.value(duration_option).toInt(), 1);
+    options.fault_interval = qMax(parser.value(fault_interval_option).toInt(), 0);
+    options.fault_time = qMax(parser.value(fault_time_option).toInt(), 1);
+    options.report_interval = qMax(parser.value(report_option).toInt(), 1);
+    options.memory_growth = qMax(parser.value(growth_option).toLongLong(), qint64{0});
+    options.fd = parser.isSet(fd_option);
+
+    zlg::stress::Harness harness{options};
+    QString error{};
+    if(!harness.open(error))
+    {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return 2;
+    }
+    const auto result{harness.run()};
+    if(!zlg::tools::write_report(result, parser.value(command_line.output)))
+    {
+        return 2;
+    }
+    return result["passed"].toBool() ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+#include "zlgcantools.h"
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QTimer>
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+/*!
+ * Both channels of one simulated ZCAN_USBCANFD_200U send through ZCAN_TransmitData
+ * from their own transmit threads at the same time, with merged reception and tx
+ * echoes on. Every frame has to reach the other channel once and in order, every
+ * frame has to be confirmed through framesWritten, and the device-level calls have
+ * to go through the adapter's transmit lock.
+ */
+namespace zlg::test
+{
+    constexpr int channels{2};
+    constexpr quint64 frames{20000};
+    constexpr int timeout{20000};
+
+    struct Channel
+    {
+        std::unique_ptr<ZlgCanBackend> backend{};
+        quint64 sent{0};
+        quint64 expected{0};
+        qint64 written{0};
+        qint64 unexpected{0};
+    };
+
+    int failures{0};
+
+    void check(bool condition, const QString& what)
+    {
+        if(!condition)
+        {
+            std::fprintf(stderr, "FAIL: %s\n", qPrintable(what));
+            ++failures;
+        }
+    }
+
+    void run()
+    {
+        tools::Options options{};
+        options.device = "ZCAN_USBCANFD_200U";
+        options.receive_mode = ZlgCanBackend::ThreadReceiveMode;
+        options.merge_receive = true;
+
+        std::vector<Channel> bus(channels);
+        for(auto i{0}; i < channels; ++i)
+        {
+            QString error{};
+            bus[i].backend = tools::open_backend(options, 0, static_cast<unsigned int>(i), false, {
+                {ZlgCanBackend::TransmitDataKey, true},
+                {ZlgCanBackend::TransmitModeKey, ZlgCanBackend::ThreadTransmitMode},
+            }, error);
+            check(nullptr != bus[i].backend, error);
+            if(!bus[i].backend)
+            {
+                return;
+            }
+        }
+
+        QEventLoop loop{};
+        auto done{[&]() {
+            for(const auto& channel: bus)
+            {
+                if(channel.expected < frames || channel.written < static_cast<qint64>(frames))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }};
+        for(auto i{0}; i < channels; ++i)
+        {
+            auto& channel{bus[i]};
+            QObject::connect(channel.backend.get(), &QCanBusDevice::framesReceived, channel.backend.get(), [&, i]() {
+                for(const auto& frame: channel.backend->readAllFrames())
+                {
+                    // the other channel's frames only, numbered without gaps
+                    const auto other{static_cast<quint32>((i + 1) % channels)};
+                    if(QCanBusFrame::DataFrame == frame.frameType() && 0x100 + other == frame.frameId() && channel.expected == tools::sequence_of(frame))
+                    {
+                        ++channel.expected;
+                    }
+                    else
+                    {
+                        ++channel.unexpected;
+                    }
+                }
+                if(done())
+                {
+                    loop.quit();
+                }
+            });
+            QObject::connect(channel.backend.get(), &QCanBusDevice::framesWritten, channel.backend.get(), [&](qint64 count) {
+                channel.written += count;
+                if(done())
+                {
+                    loop.quit();
+                }
+            });
+        }
+
+        // both channels fill their transmit queues on every pass, so their transmit threads overlap
+        QTimer feeder{};
+        QObject::connect(&feeder, &QTimer::timeout, [&]() {
+            for(auto i{0}; i < channels; ++i)
+            {
+                auto& channel{bus[i]};
+                while(channel.sent < frames && channel.backend->writeFrame(tools::sequence_frame(0x100 + static_cast<quint32>(i), channel.sent, false)))
+                {
+                    ++channel.sent;
+                }
+            }
+        });
+        feeder.start(0);
+        QTimer::singleShot(timeout, &loop, [&]() {
+            loop.quit();
+        });
+        loop.exec();
+        feeder.stop();
+
+        for(auto i{0}; i < channels; ++i)
+        {
+            const auto& channel{bus[i]};
+            check(frames == channel.sent, QString{"channel %1 sent %2 of %3 frames"}.arg(i).arg(channel.sent).arg(frames));
+            check(frames == channel.expected, QString{"channel %1 received %2 of %3 frames in order"}.arg(i).arg(channel.expected).arg(frames));
+            check(!channel.unexpected, QString{"channel %1 received %2 unexpected frames"}.arg(i).arg(channel.unexpected));
+            check(static_cast<qint64>(frames) == channel.written, QString{"channel %1 confirmed %2 of %3 frames"}.arg(i).arg(channel.written).arg(frames));
+        }
+        const auto device_lock{bus.front().backend->lockStatistics(ZlgCanBackend::DeviceTransmitLock)};
+        check(device_lock.acquisitions > 0, "ZCAN_TransmitData did not take the adapter's transmit lock");
+        std::fprintf(stderr, "adapter transmit lock: %llu acquisitions, %llu contended\n", static_cast<unsigned long long>(device_lock.acquisitions), static_cast<unsigned long long>(device_lock.contentions));
+    }
+} //namespace zlg::test
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app{argc, argv};
+
+    zlg::test::run();
+    if(zlg::test::failures)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", zlg::test::failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("all checks passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,75 @@
+#include "zlgcanerror_p.h"
+
+#include <QString>
+
+#include <cstdio>
+#include <cstdlib>
+
+/*!
+ * ZCANErrorData records translate to SocketCAN error frames. Every record carries
+ * the node state, but only a node state change report may turn it into a
+ * controller problem, so a bus error on an error active node stays a bus error.
+ */
+namespace zlg::test
+{
+    int failures{0};
+
+    void check(bool condition, const QString& what)
+    {
+        if(!condition)
+        {
+            std::fprintf(stderr, "FAIL: %s\n", qPrintable(what));
+            ++failures;
+        }
+    }
+
+    void bus_error()
+    {
+        ZCANErrorData data{};
+        data.errType = ZCAN_ERR_TYPE_BUS_ERR;
+        data.errSubType = ZCAN_BUS_ERR_CRC_ERR;
+        data.nodeState = ZCAN_NODE_STATE_ACTIVE;
+        data.rxErrCount = 8;
+
+        const auto frame{error::from(data)};
+        check((QCanBusFrame::ProtocolViolationError | QCanBusFrame::BusError) == frame.error_class, "a CRC error is a protocol violation and a bus error only");
+        check(error::prot_loc_crc_seq == frame.payload[3], "a CRC error is located in the CRC sequence");
+        check(0 == frame.payload[1], "a CRC error reports no controller problem");
+        check(8 == frame.payload[7], "the receive error counter is carried along");
+
+        ZCANDataObj data_obj{};
+        data_obj.dataType = ZCAN_DT_ZCAN_ERROR_DATA;
+        data_obj.data.zcanErrData = data;
+        check(!error::pass(data_obj, QCanBusFrame::ControllerError), "a controller error filter holds a CRC error back");
+    }
+
+    void state_change()
+    {
+        ZCANErrorData data{};
+        data.errType = ZCAN_ERR_TYPE_BUS_ERR;
+        data.errSubType = ZCAN_BUS_ERR_NODE_STATE_CHAGE;
+        data.nodeState = ZCAN_NODE_STATE_PASSIVE;
+        data.rxErrCount = 10;
+        data.txErrCount = 128;
+
+        const auto frame{error::from(data)};
+        check(QCanBusFrame::ControllerError == frame.error_class, "a change to error passive is a controller problem");
+        check(error::crtl_tx_passive == frame.payload[1], "the transmit side crossed the passive limit");
+
+        data.nodeState = ZCAN_NODE_STATE_BUSOFF;
+        check(QCanBusFrame::BusOffError == error::from(data).error_class, "a change to bus off is a bus off error");
+    }
+} //namespace zlg::test
+
+int main()
+{
+    zlg::test::bus_error();
+    zlg::test::state_change();
+    if(zlg::test::failures)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", zlg::test::failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("all checks passed\n");
+    return EXIT_SUCCESS;
+}
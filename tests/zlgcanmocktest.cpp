@@ -0,0 +1,148 @@
+#include "zlgcan/zlgcan.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+/*!
+ * End to end check of the simulated libzlgcan (ZLGCAN_MOCK) through its C API:
+ * a frame written on channel 0 is received on channel 1 of the same device, a
+ * merged transmit with an echo request comes back to the sender as well, and
+ * closing the device releases a receiver blocked without a timeout.
+ */
+namespace zlg::test
+{
+    constexpr UINT device_type{ZCAN_USBCAN2};
+    constexpr int receive_wait{1000};
+
+    int failures{0};
+
+    void check(bool condition, const char* what)
+    {
+        if(!condition)
+        {
+            std::fprintf(stderr, "FAIL: %s\n", what);
+            ++failures;
+        }
+    }
+
+    CHANNEL_HANDLE start_channel(DEVICE_HANDLE device, UINT index)
+    {
+        ZCAN_CHANNEL_INIT_CONFIG config{};
+        config.can_type = TYPE_CAN;
+        const auto channel{ZCAN_InitCAN(device, index, &config)};
+        if(INVALID_CHANNEL_HANDLE == channel || STATUS_OK != ZCAN_StartCAN(channel))
+        {
+            return INVALID_CHANNEL_HANDLE;
+        }
+        return channel;
+    }
+
+    void test_loopback()
+    {
+        const auto device{ZCAN_OpenDevice(device_type, 0, 0)};
+        check(INVALID_DEVICE_HANDLE != device, "loopback: open device");
+        if(INVALID_DEVICE_HANDLE == device)
+        {
+            return;
+        }
+        const auto sender{start_channel(device, 0)};
+        const auto receiver{start_channel(device, 1)};
+        check(INVALID_CHANNEL_HANDLE != sender && INVALID_CHANNEL_HANDLE != receiver, "loopback: start channels");
+
+        ZCAN_Transmit_Data transmit{};
+        transmit.frame.can_id = 0x123;
+        transmit.frame.can_dlc = 4;
+        std::memcpy(transmit.frame.data, "\x01\x02\x03\x04", 4);
+        check(1 == ZCAN_Transmit(sender, &transmit, 1), "loopback: transmit");
+
+        ZCAN_Receive_Data receive{};
+        check(1 == ZCAN_Receive(receiver, &receive, 1, receive_wait), "loopback: receive on the other channel");
+        check(0x123 == receive.frame.can_id && 4 == receive.frame.can_dlc && 0 == std::memcmp(receive.frame.data, transmit.frame.data, 4), "loopback: received frame matches");
+        check(0 == ZCAN_Receive(sender, &receive, 1, 0), "loopback: nothing received by the sender");
+
+        check(STATUS_OK == ZCAN_CloseDevice(device), "loopback: close device");
+    }
+
+    void test_merged_echo()
+    {
+        const auto device{ZCAN_OpenDevice(device_type, 1, 0)};
+        check(INVALID_DEVICE_HANDLE != device, "echo: open device");
+        if(INVALID_DEVICE_HANDLE == device)
+        {
+            return;
+        }
+        check(STATUS_OK == ZCAN_SetValue(device, "0/set_device_recv_merge", "1"), "echo: enable merged reception");
+        check(INVALID_CHANNEL_HANDLE != start_channel(device, 0) && INVALID_CHANNEL_HANDLE != start_channel(device, 1), "echo: start channels");
+
+        ZCANDataObj transmit{};
+        transmit.dataType = ZCAN_DT_ZCAN_CAN_CANFD_DATA;
+        transmit.chnl = 0;
+        transmit.data.zcanCANFDData.flag.unionVal.txEchoRequest = 1;
+        transmit.data.zcanCANFDData.frame.can_id = 0x321;
+        transmit.data.zcanCANFDData.frame.len = 8;
+        check(1 == ZCAN_TransmitData(device, &transmit, 1), "echo: transmit");
+
+        ZCANDataObj receive[4]{};
+        auto received{UINT{0}};
+        for(auto attempt{0}; received < 2 && attempt < 10; ++attempt)
+        {
+            received += ZCAN_ReceiveData(device, receive + received, 4 - received, receive_wait / 10);
+        }
+        check(2 == received, "echo: one frame and one echo received");
+        auto frames{0};
+        auto echoes{0};
+        for(auto i{UINT{0}}; i < received; ++i)
+        {
+            const auto& can_data{receive[i].data.zcanCANFDData};
+            check(ZCAN_DT_ZCAN_CAN_CANFD_DATA == receive[i].dataType && 0x321 == can_data.frame.can_id, "echo: received record matches");
+            if(0 == receive[i].chnl && can_data.flag.unionVal.txEchoed)
+            {
+                ++echoes;
+            }
+            else if(1 == receive[i].chnl && !can_data.flag.unionVal.txEchoed)
+            {
+                ++frames;
+            }
+        }
+        check(1 == frames && 1 == echoes, "echo: frame on channel 1 and echo on channel 0");
+
+        check(STATUS_OK == ZCAN_CloseDevice(device), "echo: close device");
+    }
+
+    void test_close_wakes_receiver()
+    {
+        const auto device{ZCAN_OpenDevice(device_type, 2, 0)};
+        check(INVALID_DEVICE_HANDLE != device, "close: open device");
+        if(INVALID_DEVICE_HANDLE == device)
+        {
+            return;
+        }
+        const auto channel{start_channel(device, 0)};
+        auto received{UINT{1}};
+        std::thread receiver{[&]() {
+            ZCAN_Receive_Data receive{};
+            received = ZCAN_Receive(channel, &receive, 1, -1);
+        }};
+        std::this_thread::sleep_for(std::chrono::milliseconds{50});
+        check(STATUS_OK == ZCAN_CloseDevice(device), "close: close device");
+        receiver.join();
+        check(0 == received, "close: blocked receiver returns nothing");
+    }
+} //namespace zlg::test
+
+int main()
+{
+    zlg::test::test_loopback();
+    zlg::test::test_merged_echo();
+    zlg::test::test_close_wakes_receiver();
+    if(zlg::test::failures)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", zlg::test::failures);
+        return EXIT_FAILURE;
+    }
+    std::printf("all checks passed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,109 @@
+#include "zlgcantools.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QJsonDocument>
+#include <QLoggingCategory>
+
+#include <cstdio>
+#include <cstring>
+
+QT_BEGIN_NAMESPACE
+
+Q_LOGGING_CATEGORY(QT_CANBUS_PLUGINS_ZLGCAN, "qt.canbus.plugins.zlgcan")
+
+QT_END_NAMESPACE
+
+namespace zlg::tools
+{
+    CommandLine::CommandLine(const QString& default_device):
+        device{"device", "Device type name from devices.xml.", "type", default_device},
+        receive_mode{"receive-mode", "timer, thread or adaptive.", "mode", "timer"},
+        merge_receive{"merge-receive", "Receive through ZCAN_ReceiveData."},
+        output{"output", "Write the JSON report to a file instead of stdout.", "file"}
+    {
+    }
+
+    void CommandLine::addTo(QCommandLineParser& parser) const
+    {
+        parser.addOptions({device, receive_mode, merge_receive, output});
+    }
+
+    void CommandLine::read(const QCommandLineParser& parser, Options& options) const
+    {
+        options.device = parser.value(device);
+        options.receive_mode = tools::receive_mode(parser.value(receive_mode));
+        options.merge_receive = parser.isSet(merge_receive);
+    }
+
+    int receive_mode(const QString& name)
+    {
+        if("thread" == name)
+        {
+            return ZlgCanBackend::ThreadReceiveMode;
+        }
+        if("adaptive" == name)
+        {
+            return ZlgCanBackend::AdaptiveTimerReceiveMode;
+        }
+        return ZlgCanBackend::TimerReceiveMode;
+    }
+
+    QString interface_name(const QString& device, unsigned int index, unsigned int channel)
+    {
+        return QString{"<Device type=\"%1\" index=\"%2\" channel=\"%3\" />"}.arg(device).arg(index).arg(channel);
+    }
+
+    std::unique_ptr<ZlgCanBackend> open_backend(const Options& options, unsigned int index, unsigned int channel, bool fd, const QMap<int, QVariant>& parameters, QString& error)
+    {
+        auto backend{std::make_unique<ZlgCanBackend>(interface_name(options.device, index, channel))};
+        backend->setConfigurationParameter(QCanBusDevice::CanFdKey, fd);
+        backend->setConfigurationParameter(static_cast<QCanBusDevice::ConfigurationKey>(ZlgCanBackend::ReceiveModeKey), options.receive_mode);
+        backend->setConfigurationParameter(static_cast<QCanBusDevice::ConfigurationKey>(ZlgCanBackend::MergeReceiveKey), options.merge_receive);
+        for(auto iter{parameters.cbegin()}; iter != parameters.cend(); ++iter)
+        {
+            backend->setConfigurationParameter(static_cast<QCanBusDevice::ConfigurationKey>(iter.key()), iter.value());
+        }
+        if(!backend->connectDevice() || QCanBusDevice::ConnectedState != backend->state())
+        {
+            error = QString{"Cannot open device %1 channel %2: %3"}.arg(index).arg(channel).arg(backend->errorString());
+            return {};
+        }
+        return backend;
+    }
+
+    QCanBusFrame sequence_frame(quint32 id, quint64 sequence, bool fd, bool bitrate_switch)
+    {
+        QByteArray payload(fd ? 64 : 8, '\0');
+        ::memcpy(payload.data(), &sequence, sizeof(sequence));
+        QCanBusFrame frame{id, payload};
+        frame.setFlexibleDataRateFormat(fd);
+        frame.setBitrateSwitch(fd && bitrate_switch);
+        return frame;
+    }
+
+    quint64 sequence_of(const QCanBusFrame& frame)
+    {
+        auto sequence{quint64{0}};
+        const auto payload{frame.payload()};
+        ::memcpy(&sequence, payload.constData(), qMin<std::size_t>(sizeof(sequence), payload.size()));
+        return sequence;
+    }
+
+    bool write_report(const QJsonObject& report, const QString& file)
+    {
+        const auto json{QJsonDocument{report}.toJson(QJsonDocument::Indented)};
+        if(file.isEmpty())
+        {
+            std::fwrite(json.constData(), 1, json.size(), stdout);
+            return true;
+        }
+        QFile output{file};
+        if(!output.open(QIODevice::WriteOnly | QIODevice::Truncate) || json.size() != output.write(json))
+        {
+            std::fprintf(stderr, "Cannot write %s\n", qPrintable(file));
+            return false;
+        }
+        return true;
+    }
+} //namespace zlg::tools
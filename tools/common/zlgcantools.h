@@ -0,0 +1,61 @@
+#ifndef ZLGCANTOOLS_H
+#define ZLGCANTOOLS_H
+
+#include "zlgcanbackend.h"
+
+#include <QCanBusFrame>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QJsonObject>
+#include <QMap>
+#include <QString>
+#include <QVariant>
+
+#include <memory>
+
+/*!
+ * Shared by zlgcanbench, zlgcanstress and the tests: the backend sources built
+ * into one static library, the log category the plugin normally defines, and
+ * the helpers every tool needs to open channels, number frames and report.
+ */
+namespace zlg::tools
+{
+    // what every tool asks for on the command line
+    struct Options
+    {
+        QString device{};
+        int receive_mode{ZlgCanBackend::TimerReceiveMode};
+        bool merge_receive{false};
+        bool fd{false};
+    };
+
+    // --device, --receive-mode, --merge-receive and --output
+    struct CommandLine
+    {
+        explicit CommandLine(const QString& default_device);
+
+        void addTo(QCommandLineParser& parser) const;
+        void read(const QCommandLineParser& parser, Options& options) const;
+
+        QCommandLineOption device;
+        QCommandLineOption receive_mode;
+        QCommandLineOption merge_receive;
+        QCommandLineOption output;
+    };
+
+    int receive_mode(const QString& name);
+
+    QString interface_name(const QString& device, unsigned int index, unsigned int channel);
+
+    // connects channel of device index with the options and the extra configuration parameters, error is set on failure
+    std::unique_ptr<ZlgCanBackend> open_backend(const Options& options, unsigned int index, unsigned int channel, bool fd, const QMap<int, QVariant>& parameters, QString& error);
+
+    // the sequence number goes into the first 8 bytes of an 8 or 64 byte payload
+    QCanBusFrame sequence_frame(quint32 id, quint64 sequence, bool fd, bool bitrate_switch = false);
+    quint64 sequence_of(const QCanBusFrame& frame);
+
+    // writes the report to file, or to stdout when file is empty
+    bool write_report(const QJsonObject& report, const QString& file);
+} //namespace zlg::tools
+
+#endif // ZLGCANTOOLS_H